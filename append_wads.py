@@ -1,4 +1,5 @@
 import argparse
+import hashlib
 import os
 import struct
 
@@ -6,9 +7,415 @@ parser = argparse.ArgumentParser()
 parser.add_argument("input_file", help=".bin to append files to")
 parser.add_argument("output_file")
 parser.add_argument("append_file", nargs="*", help="File(s) to append")
+parser.add_argument("--no-precompile", action="store_true", help="Don't add PRECOMP lumps to the levels in WADs")
 
 args = parser.parse_args()
 
+# same as W_LumpNameHash
+def lump_name_hash(name):
+    result = 5381
+
+    for c in name[:8]:
+        if c == 0:
+            break
+
+        if c >= ord('a') and c <= ord('z'):
+            c -= 32
+
+        result = (((result << 5) ^ result) ^ c) & 0xFFFFFFFF
+
+    return result
+
+# build a lump name index for W_CheckNumForName (see lumpindexheader_t)
+# the tables are padded to be 4 byte aligned when the index is written at data_offset
+def build_lump_index(wad_data, data_offset):
+    num_lumps, info_table_offset = struct.unpack('<ii', wad_data[4:12])
+    num_buckets = max(num_lumps, 1)
+
+    buckets = [-1] * num_buckets
+    next_lump = [-1] * num_lumps
+
+    # later lumps at the head of the chains so they take precedence
+    for i in range(num_lumps):
+        entry_off = info_table_offset + i * 16
+        name = wad_data[entry_off + 8:entry_off + 16]
+
+        bucket = lump_name_hash(name) % num_buckets
+        next_lump[i] = buckets[bucket]
+        buckets[bucket] = i
+
+    header_size = 20
+    table_offset = header_size + (-(data_offset + header_size) % 4)
+
+    index = b'LIDX' + struct.pack('<iiii', num_lumps, info_table_offset, num_buckets, table_offset)
+    index += b'\0' * (table_offset - header_size)
+    index += struct.pack('<%ii' % num_buckets, *buckets)
+    index += struct.pack('<%ii' % num_lumps, *next_lump)
+
+    return index
+
+# find a lump in a WAD, returns the last one like W_CheckNumForName
+def find_lump(wad_data, lump_name):
+    num_lumps, info_table_offset = struct.unpack('<ii', wad_data[4:12])
+
+    for i in reversed(range(num_lumps)):
+        entry_off = info_table_offset + i * 16
+        file_pos, size = struct.unpack('<ii', wad_data[entry_off:entry_off + 8])
+        name = wad_data[entry_off + 8:entry_off + 16].rstrip(b'\0')
+
+        if name.upper() == lump_name:
+            return wad_data[file_pos:file_pos + size]
+
+    return None
+
+# lumps following a level's marker, in order (see ML_THINGS..ML_BLOCKMAP)
+map_lumps = [b'THINGS', b'LINEDEFS', b'SIDEDEFS', b'VERTEXES', b'SEGS',
+             b'SSECTORS', b'NODES', b'SECTORS', b'REJECT', b'BLOCKMAP']
+
+def read_directory(wad_data):
+    num_lumps, info_table_offset = struct.unpack('<ii', wad_data[4:12])
+    directory = []
+
+    for i in range(num_lumps):
+        entry_off = info_table_offset + i * 16
+        file_pos, size = struct.unpack('<ii', wad_data[entry_off:entry_off + 8])
+        name = wad_data[entry_off + 8:entry_off + 16].split(b'\0')[0].upper()
+        directory.append((file_pos, size, name))
+
+    return directory
+
+# a level's vertexes and segs as vertex_t and seg_t, see precomplevel_t and
+# P_LoadPrecompiled (segs are converted the same way as P_LoadSegs)
+# returns None if the level has references out of range
+def build_precompiled_level(wad_data, directory, marker):
+    def map_lump(ml):
+        file_pos, size, name = directory[marker + ml]
+        return wad_data[file_pos:file_pos + size]
+
+    linedefs = map_lump(2)
+    sidedefs = map_lump(3)
+    vertexes = map_lump(4)
+    segs = map_lump(5)
+    num_sectors = len(map_lump(8)) // 26
+
+    lines = list(struct.iter_unpack('<7h', linedefs[:len(linedefs) // 14 * 14]))
+    side_sectors = [struct.unpack_from('<h', sidedefs, i * 30 + 28)[0] for i in range(len(sidedefs) // 30)]
+
+    if any(sector < 0 or sector >= num_sectors for sector in side_sectors):
+        return None
+
+    out_vertexes = b''
+    for x, y in struct.iter_unpack('<hh', vertexes[:len(vertexes) // 4 * 4]):
+        out_vertexes += struct.pack('<ii', x << 16, y << 16)
+
+    num_vertexes = len(out_vertexes) // 8
+
+    out_segs = b''
+    for v1, v2, angle, linedef, side, offset in struct.iter_unpack('<6h', segs[:len(segs) // 12 * 12]):
+        if linedef < 0 or linedef >= len(lines) or side not in (0, 1):
+            return None
+
+        if v1 < 0 or v1 >= num_vertexes or v2 < 0 or v2 >= num_vertexes:
+            return None
+
+        flags = lines[linedef][2]
+        sidenum = lines[linedef][5:7]
+        front_side = sidenum[side]
+
+        if front_side < 0 or front_side >= len(side_sectors):
+            return None
+
+        if flags & 4: # ML_TWOSIDED
+            back_side = sidenum[side ^ 1]
+
+            # "glass hack", the null sector is kept after the last one
+            if back_side < 0 or back_side >= len(side_sectors):
+                back_sector = num_sectors
+            else:
+                back_sector = side_sectors[back_side]
+        else:
+            back_sector = 0xFFFF # NO_INDEX
+
+        out_segs += struct.pack('<HHhhHHHH', v1, v2, offset, angle, front_side, linedef,
+                                side_sectors[front_side], back_sector)
+
+    header_size = 32
+    header = b'PLVL' + struct.pack('<7i', 1, 8, 16, num_vertexes, header_size,
+                                   len(out_segs) // 16, header_size + len(out_vertexes))
+
+    return header + out_vertexes + out_segs
+
+# add a PRECOMP lump after each level's BLOCKMAP, aligned to 4 bytes once
+# the WAD is written at data_offset so that it can be used in place
+# returns the new WAD and the number of levels
+def add_precompiled_levels(wad_data, data_offset):
+    num_lumps, info_table_offset = struct.unpack('<ii', wad_data[4:12])
+    directory = read_directory(wad_data)
+
+    # drop the old directory if it's at the end, a new one is written
+    if info_table_offset + num_lumps * 16 == len(wad_data):
+        out = bytearray(wad_data[:info_table_offset])
+    else:
+        out = bytearray(wad_data)
+
+    new_directory = []
+    num_levels = 0
+
+    for i, entry in enumerate(directory):
+        new_directory.append(entry)
+
+        marker = i - len(map_lumps)
+        if marker < 0 or [name for _, _, name in directory[marker + 1:i + 1]] != map_lumps:
+            continue
+
+        if i + 1 < len(directory) and directory[i + 1][2] == b'PRECOMP':
+            continue
+
+        level = build_precompiled_level(wad_data, directory, marker)
+        if level is None:
+            print("Not precompiling %s, it has references out of range" % directory[marker][2].decode())
+            continue
+
+        out += b'\0' * (-(data_offset + len(out)) % 4)
+        new_directory.append((len(out), len(level), b'PRECOMP'))
+        out += level
+        num_levels += 1
+
+    if num_levels == 0:
+        return wad_data, 0
+
+    out[4:12] = struct.pack('<ii', len(new_directory), len(out))
+
+    for file_pos, size, name in new_directory:
+        out += struct.pack('<ii8s', file_pos, size, name)
+
+    return bytes(out), num_levels
+
+# same as W_Checksum, for a set of WADs loaded in this order
+def wad_checksum(wads):
+    sha1 = hashlib.sha1()
+
+    for file_number, wad_data in enumerate(wads):
+        num_lumps, info_table_offset = struct.unpack('<ii', wad_data[4:12])
+
+        for i in range(num_lumps):
+            entry_off = info_table_offset + i * 16
+            file_pos, size = struct.unpack('<II', wad_data[entry_off:entry_off + 8])
+            name = wad_data[entry_off + 8:entry_off + 16].split(b'\0')[0]
+
+            sha1.update(name + b'\0')
+            sha1.update(struct.pack('>III', file_number, file_pos, size))
+
+    return sha1.digest()
+
+def to_fixed(value):
+    return ((value << 16) + 0x80000000) % 0x100000000 - 0x80000000
+
+# what R_InitTextures, R_GenerateLookup and R_InitSpriteLumps work out
+# for a set of WADs, None if the game would fail to start with them
+def build_render_tables(wads):
+    lumps = []
+    lump_nums = {}
+
+    for wad_data in wads:
+        for file_pos, size, name in read_directory(wad_data):
+            lump_nums[name] = len(lumps)
+            lumps.append(wad_data[file_pos:file_pos + size])
+
+    # W_CheckNumForName, the last one wins
+    def find(name):
+        return lump_nums.get(name.upper(), -1)
+
+    if find(b'PNAMES') < 0 or find(b'TEXTURE1') < 0 or find(b'S_START') < 0 or find(b'S_END') < 0:
+        return None
+
+    pnames = lumps[find(b'PNAMES')]
+    num_patches = struct.unpack_from('<i', pnames)[0]
+    patch_lookup = [find(pnames[4 + i * 8:12 + i * 8].split(b'\0')[0]) for i in range(num_patches)]
+
+    textures = []
+
+    for texture_lump in (b'TEXTURE1', b'TEXTURE2'):
+        if find(texture_lump) < 0:
+            continue
+
+        maptex = lumps[find(texture_lump)]
+
+        for i in range(struct.unpack_from('<i', maptex)[0]):
+            offset = struct.unpack_from('<i', maptex, 4 + i * 4)[0]
+            _, _, width, height, _, patch_count = struct.unpack_from('<8sihhih', maptex, offset)
+
+            patches = []
+            for j in range(patch_count):
+                origin_x, origin_y, patch = struct.unpack_from('<3h', maptex, offset + 22 + j * 10)
+                if patch_lookup[patch] < 0:
+                    return None
+
+                patches.append((origin_x, patch_lookup[patch]))
+
+            textures.append((width, height, patches))
+
+    composite_sizes = []
+    width_masks = []
+    heights = []
+    column_lumps = []
+    column_ofs = []
+
+    for width, height, patches in textures:
+        mask = 1
+        while mask * 2 <= width:
+            mask <<= 1
+
+        width_masks.append(mask - 1)
+        heights.append(to_fixed(height))
+
+        patch_count = [0] * max(width, 0)
+        lump = [0] * max(width, 0)
+        ofs = [0] * max(width, 0)
+
+        for origin_x, patch in patches:
+            patch_data = lumps[patch]
+            x1 = origin_x
+            x2 = min(x1 + struct.unpack_from('<h', patch_data)[0], width)
+
+            for x in range(max(x1, 0), x2):
+                patch_count[x] += 1
+                lump[x] = patch
+                ofs[x] = (struct.unpack_from('<i', patch_data, 8 + (x - x1) * 4)[0] + 3) & 0xFFFF
+
+        composite_size = 0
+
+        for x in range(len(patch_count)):
+            # "column without a patch", the rest is left as it is
+            if patch_count[x] == 0:
+                break
+
+            if patch_count[x] > 1:
+                lump[x] = -1
+                ofs[x] = composite_size
+
+                if composite_size > 0x10000 - height:
+                    return None
+
+                composite_size += height
+
+        composite_sizes.append(composite_size)
+        column_lumps += [(l + 0x8000) % 0x10000 - 0x8000 for l in lump]
+        column_ofs += ofs
+
+    sprites = []
+
+    for i in range(find(b'S_START') + 1, find(b'S_END')):
+        if len(lumps[i]) >= 8:
+            width, _, left_offset, top_offset = struct.unpack_from('<4h', lumps[i])
+        else:
+            width, left_offset, top_offset = 0, 0, 0
+
+        sprites.append((to_fixed(width), to_fixed(left_offset), to_fixed(top_offset)))
+
+    return (composite_sizes, width_masks, heights, sprites, column_lumps, column_ofs)
+
+# bakedtables_t and its arrays, written at offset in the file
+def pack_render_tables(tables, offset):
+    composite_sizes, width_masks, heights, sprites, column_lumps, column_ofs = tables
+
+    num_textures = len(composite_sizes)
+    num_sprites = len(sprites)
+
+    # ints first, then shorts, so that everything is aligned
+    arrays = [
+        struct.pack('<%ii' % num_textures, *composite_sizes),
+        struct.pack('<%ii' % num_textures, *width_masks),
+        struct.pack('<%ii' % num_textures, *heights),
+        struct.pack('<%ii' % num_sprites, *[s[0] for s in sprites]),
+        struct.pack('<%ii' % num_sprites, *[s[1] for s in sprites]),
+        struct.pack('<%ii' % num_sprites, *[s[2] for s in sprites]),
+        struct.pack('<%ih' % len(column_lumps), *column_lumps),
+        struct.pack('<%iH' % len(column_ofs), *column_ofs),
+    ]
+
+    array_offsets = []
+    pos = offset + 11 * 4
+
+    for array in arrays:
+        array_offsets.append(pos)
+        pos += len(array)
+
+    header = struct.pack('<11i', num_textures, len(column_lumps), num_sprites, *array_offsets)
+
+    return header + b''.join(arrays)
+
+# tables for each IWAD on its own and with all of the PWADs (see
+# R_LoadBakedTables), the file is written at data_offset
+def build_render_tables_file(iwads, pwads, data_offset):
+    entries = []
+
+    for iwad in iwads:
+        for wads in ([iwad], [iwad] + pwads) if pwads else ([iwad],):
+            try:
+                tables = build_render_tables(wads)
+            except (struct.error, IndexError):
+                tables = None
+
+            if tables is not None:
+                entries.append((wad_checksum(wads), tables))
+
+    out = bytearray(b'RTBL' + struct.pack('<i', len(entries)) + b'\0' * 24 * len(entries))
+
+    for i, (digest, tables) in enumerate(entries):
+        out += b'\0' * (-(data_offset + len(out)) % 4)
+        struct.pack_into('<20si', out, 8 + i * 24, digest, len(out))
+        out += pack_render_tables(tables, len(out))
+
+    return bytes(out), len(entries)
+
+# same as FindNearestColor in i_scale.c
+def find_nearest_color(palette, r, g, b):
+    best = 0
+    best_diff = 1 << 31
+
+    for i in range(256):
+        pr, pg, pb = palette[i * 3:i * 3 + 3]
+        diff = (r - pr) * (r - pr) + (g - pg) * (g - pg) + (b - pb) * (b - pb)
+
+        if diff < best_diff:
+            best = i
+            best_diff = diff
+
+            if diff == 0:
+                break
+
+    return best
+
+# same as GenerateStretchTable in i_scale.c
+def generate_stretch_table(palette, pct):
+    result = bytearray(256 * 256)
+    nearest = {}
+
+    for x in range(256):
+        col1 = palette[x * 3:x * 3 + 3]
+        for y in range(256):
+            col2 = palette[y * 3:y * 3 + 3]
+            col = tuple((col1[i] * pct + col2[i] * (100 - pct)) // 100 for i in range(3))
+
+            if col not in nearest:
+                nearest[col] = find_nearest_color(palette, *col)
+
+            result[x * 256 + y] = nearest[col]
+
+    return result
+
+# build the aspect ratio correction tables for each palette (see I_InitStretchTables)
+def build_stretch_tables(palettes):
+    tables = b'STRT' + struct.pack('<I', len(palettes))
+
+    for palette in palettes:
+        tables += palette
+        tables += generate_stretch_table(palette, 20)
+        tables += generate_stretch_table(palette, 40)
+
+    return tables
+
 # grab metadata / length
 in_file = open(args.input_file, "rb")
 head = in_file.read(20)
@@ -29,18 +436,68 @@ in_file.seek(0)
 out_file = open(args.output_file, "wb")
 out_file.write(in_file.read(in_file_end + head_off))
 
-# header
-out_file.write(b"APPFILES")
-out_file.write(struct.pack("<I", len(args.append_file)))
+# files to append, WADs get an index file next to them
+files = []
+palettes = []
 
 for filename in args.append_file:
     basename = "doom-data/" + os.path.basename(filename)
-    out_file.write(struct.pack("HxxI", len(basename), os.stat(filename).st_size))
+    data = open(filename, "rb").read()
+    files.append((basename, data))
 
-for filename in args.append_file:
-    basename = "doom-data/" + os.path.basename(filename)
+    if basename.lower().endswith(".wad") and data[:4] in (b'IWAD', b'PWAD'):
+        # replaced with the index once we know where it goes
+        files.append((basename + ".idx", data))
+
+        playpal = find_lump(data, b'PLAYPAL')
+        if playpal and len(playpal) >= 768 and playpal[:768] not in palettes:
+            palettes.append(playpal[:768])
+
+if palettes:
+    print("Generating stretch tables for %i palette(s)..." % len(palettes))
+    files.append(("doom-data/stretch.tbl", build_stretch_tables(palettes)))
+
+# baked once the WADs are final
+if any(basename.endswith(".idx") for basename, _ in files):
+    files.append(("doom-data/rdata.tbl", b''))
+
+# now that we know the header size, work out where everything goes
+data_offset = in_file_end + head_off + 12 + 8 * len(files)
+
+for i, (basename, data) in enumerate(files):
+    data_offset += len(basename)
+
+    if basename.endswith(".idx"):
+        # the WAD before this one
+        data = build_lump_index(files[i - 1][1], data_offset)
+        files[i] = (basename, data)
+    elif basename.lower().endswith(".wad") and data[:4] in (b'IWAD', b'PWAD') and not args.no_precompile:
+        data, num_levels = add_precompiled_levels(data, data_offset)
+        files[i] = (basename, data)
+
+        if num_levels:
+            print("Precompiled %i level(s) in %s" % (num_levels, basename))
+    elif basename == "doom-data/rdata.tbl":
+        wads = [wad for name, wad in files[:i] if name.lower().endswith(".wad") and wad[:4] in (b'IWAD', b'PWAD')]
+
+        data, num_sets = build_render_tables_file([wad for wad in wads if wad[:4] == b'IWAD'],
+                                                  [wad for wad in wads if wad[:4] == b'PWAD'], data_offset)
+        files[i] = (basename, data)
+
+        print("Baked renderer tables for %i WAD set(s)" % num_sets)
+
+    data_offset += len(data)
+
+# header
+out_file.write(b"APPFILES")
+out_file.write(struct.pack("<I", len(files)))
+
+for basename, data in files:
+    out_file.write(struct.pack("HxxI", len(basename), len(data)))
+
+for basename, data in files:
     out_file.write(basename.encode())
-    out_file.write(open(filename, "rb").read())
+    out_file.write(data)
 
 new_end = out_file.tell() - head_off
 out_file.write(metadata)
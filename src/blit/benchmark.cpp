@@ -0,0 +1,862 @@
+// timedemo benchmark, plays the IWAD demos as fast as possible and reports timings
+
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <string>
+#include <vector>
+
+#include "main.h"
+
+#include "../chocdoom/d_iwad.h"
+#include "../chocdoom/d_loop.h"
+#include "../chocdoom/d_main.h"
+#include "../chocdoom/doomstat.h"
+#include "../chocdoom/g_game.h"
+#include "../chocdoom/i_video.h"
+#include "../chocdoom/m_menu.h"
+#include "../chocdoom/m_misc.h"
+#include "../chocdoom/m_profile.h"
+#include "../chocdoom/p_local.h"
+#include "../chocdoom/p_saveg.h"
+#include "../chocdoom/p_setup.h"
+#include "../chocdoom/p_ticsum.h"
+#include "../chocdoom/r_local.h"
+#include "../chocdoom/sha1.h"
+#include "../chocdoom/w_wad.h"
+#include "../chocdoom/z_zone.h"
+
+extern void D_Display();
+extern void G_DoSaveGame();
+extern boolean advancedemo;
+extern void WritePCXfile(char *filename, byte *data, int width, int height, byte *palette);
+extern int fuzzpos;
+extern boolean setsizeneeded;
+extern void R_ExecuteSetViewSize();
+
+// per-tic time histogram, upper bounds in us (last bucket is everything else)
+static const int num_buckets = 8;
+static const uint32_t bucket_limits[num_buckets - 1] = {1000, 2000, 4000, 8000, 16000, 33000, 66000};
+
+struct BenchmarkResult
+{
+    int tics = 0;
+    uint64_t time_us = 0;
+    uint32_t min_tic_us = ~0u, max_tic_us = 0;
+    int histogram[num_buckets] = {0};
+};
+
+static void add_tic(BenchmarkResult &result, uint32_t tic_us)
+{
+    result.tics++;
+    result.time_us += tic_us;
+
+    if(tic_us < result.min_tic_us)
+        result.min_tic_us = tic_us;
+    if(tic_us > result.max_tic_us)
+        result.max_tic_us = tic_us;
+
+    int bucket = 0;
+    while(bucket < num_buckets - 1 && tic_us >= bucket_limits[bucket])
+        bucket++;
+
+    result.histogram[bucket]++;
+}
+
+static void print_result(const char *name, bool draw, const BenchmarkResult &result)
+{
+    float time_s = result.time_us / 1000000.0f;
+
+    printf("%-8s %-7s %6i tics %8.3fs %8.2f fps (min %.2fms avg %.2fms max %.2fms)\n",
+           name, draw ? "draw" : "nodraw", result.tics, time_s,
+           time_s > 0.0f ? result.tics / time_s : 0.0f,
+           result.min_tic_us / 1000.0f, result.tics ? result.time_us / 1000.0f / result.tics : 0.0f, result.max_tic_us / 1000.0f);
+
+    printf("        ");
+    for(int i = 0; i < num_buckets; i++)
+    {
+        if(i < num_buckets - 1)
+            printf(" <%ims: %i", bucket_limits[i] / 1000, result.histogram[i]);
+        else
+            printf(" >=%ims: %i", bucket_limits[i - 1] / 1000, result.histogram[i]);
+    }
+    printf("\n");
+}
+
+// golden frames: every golden_interval tics of each demo, I_VideoBuffer is
+// hashed and checked against the manifest, a line of "<demo> <tic> <sha1>"
+// per frame. The raw frames are in golden_dir, checked in alongside the
+// manifest. A frame that does not match is written out as <demo>-<tic>.pcx,
+// plus <demo>-<tic>-diff.pcx with the changed pixels in red. A missing
+// manifest is a failure, DOOM_GOLDEN_RECORD=1 in the environment (re)records
+// it and the frames instead. run_benchmark forces the view settings the
+// frames depend on
+static const int golden_interval = 35;
+static const char *golden_manifest = "doom-data/golden.txt";
+static const char *golden_dir = "doom-data/golden";
+
+struct GoldenFrames
+{
+    bool recording = false, missing = false;
+    std::map<std::string, std::string> expected;
+    std::string manifest;
+    int checked = 0, failed = 0;
+};
+
+static GoldenFrames golden;
+
+static void load_golden_frames()
+{
+    const char *record = getenv("DOOM_GOLDEN_RECORD");
+
+    if(record && strcmp(record, "0") != 0)
+    {
+        golden.recording = true;
+        M_MakeDirectory((char *)golden_dir);
+        return;
+    }
+
+    if(!M_FileExists((char *)golden_manifest))
+    {
+        golden.missing = true;
+        return;
+    }
+
+    byte *data;
+    int length = M_ReadFile((char *)golden_manifest, &data);
+    std::string text((char *)data, length);
+    Z_Free(data);
+
+    size_t pos = 0;
+    while(pos < text.length())
+    {
+        size_t end = text.find('\n', pos);
+        if(end == std::string::npos)
+            end = text.length();
+
+        // key is "<demo> <tic>", value the hash
+        std::string line = text.substr(pos, end - pos);
+        size_t split = line.rfind(' ');
+        if(split != std::string::npos)
+            golden.expected[line.substr(0, split)] = line.substr(split + 1);
+
+        pos = end + 1;
+    }
+}
+
+static void write_diff_image(const std::string &name, byte *palette)
+{
+    std::string raw_name = std::string(golden_dir) + "/" + name + ".raw";
+
+    if(!M_FileExists((char *)raw_name.c_str()))
+    {
+        printf("no %s to diff against\n", raw_name.c_str());
+        return;
+    }
+
+    byte *expected;
+    if(M_ReadFile((char *)raw_name.c_str(), &expected) != SCREENWIDTH * SCREENHEIGHT)
+    {
+        printf("%s is not %ix%i\n", raw_name.c_str(), SCREENWIDTH, SCREENHEIGHT);
+        Z_Free(expected);
+        return;
+    }
+
+    // unchanged pixels darkened, changed ones bright red
+    static byte diff[SCREENWIDTH * SCREENHEIGHT];
+    for(int i = 0; i < SCREENWIDTH * SCREENHEIGHT; i++)
+        diff[i] = expected[i] == I_VideoBuffer[i] ? colormaps[20 * 256 + I_VideoBuffer[i]] : 176;
+
+    Z_Free(expected);
+
+    WritePCXfile((char *)(name + "-diff.pcx").c_str(), diff, SCREENWIDTH, SCREENHEIGHT, palette);
+}
+
+static void check_golden_frame(const char *demo, int tic)
+{
+    sha1_context_t context;
+    sha1_digest_t digest;
+    char hash[sizeof(digest) * 2 + 1], name[32];
+
+    SHA1_Init(&context);
+    SHA1_Update(&context, I_VideoBuffer, SCREENWIDTH * SCREENHEIGHT);
+    SHA1_Final(digest, &context);
+
+    for(unsigned i = 0; i < sizeof(digest); i++)
+        snprintf(hash + i * 2, 3, "%02x", digest[i]);
+
+    snprintf(name, sizeof(name), "%s-%05i", demo, tic);
+    std::string key = std::string(demo) + " " + std::to_string(tic);
+
+    if(golden.recording)
+    {
+        golden.manifest += key + " " + hash + "\n";
+        M_WriteFile((char *)(std::string(golden_dir) + "/" + name + ".raw").c_str(), I_VideoBuffer, SCREENWIDTH * SCREENHEIGHT);
+        golden.checked++;
+        return;
+    }
+
+    auto it = golden.expected.find(key);
+    if(it == golden.expected.end())
+        return;
+
+    golden.checked++;
+
+    if(it->second == hash)
+        return;
+
+    golden.failed++;
+    printf("golden frame %s differs\n", key.c_str());
+
+    byte *palette = (byte *)W_CacheLumpName((char *)"PLAYPAL", PU_CACHE);
+    WritePCXfile((char *)(std::string(name) + ".pcx").c_str(), I_VideoBuffer, SCREENWIDTH, SCREENHEIGHT, palette);
+    write_diff_image(name, palette);
+}
+
+static void finish_golden_frames()
+{
+    if(golden.recording)
+    {
+        M_WriteFile((char *)golden_manifest, (void *)golden.manifest.c_str(), golden.manifest.length());
+        printf("recorded %i golden frames to %s\n", golden.checked, golden_manifest);
+    }
+    else if(golden.missing)
+        printf("no golden frames at %s, run with DOOM_GOLDEN_RECORD=1 to record them\n", golden_manifest);
+    else
+        printf("golden frames: %i checked, %i differ\n", golden.checked, golden.failed);
+}
+
+// this is basically G_TimeDemo, but returns at the end instead of exiting with an error
+static void run_timedemo(const char *demo, bool draw, BenchmarkResult &result)
+{
+    advancedemo = false;
+    nodrawers = !draw;
+    singletics = true;
+
+    G_DeferedPlayDemo((char *)demo);
+
+    // run one tic at a time until the demo ends (G_CheckDemoStatus clears demoplayback)
+    while(gameaction == ga_playdemo || demoplayback)
+    {
+        uint32_t start = blit::now_us();
+
+        TryRunTics();
+        D_Display();
+
+        add_tic(result, blit::us_diff(start, blit::now_us()));
+
+        // not timed
+        if(draw && result.tics % golden_interval == 0)
+            check_golden_frame(demo, result.tics);
+    }
+
+    nodrawers = false;
+    singletics = false;
+}
+
+// times R_SortVisSprites on random scales (with plenty of ties) and checks
+// that the order matches vanilla: back to front, ties in spawn order
+static void benchmark_sprite_sort()
+{
+    static const int counts[] = {16, 64, 128};
+    static const int iterations = 1000;
+    static vissprite_t sprites[128];
+
+    auto old_vissprites = vissprites, old_vissprite_p = vissprite_p;
+    vissprites = sprites;
+
+    srand(1);
+
+    for(auto count : counts)
+    {
+        uint32_t time_us = 0;
+        bool ok = true;
+
+        vissprite_p = vissprites + count;
+
+        for(int it = 0; it < iterations; it++)
+        {
+            for(int i = 0; i < count; i++)
+                sprites[i].scale = (rand() % 64) << 12;
+
+            uint32_t start = blit::now_us();
+            R_SortVisSprites();
+            time_us += blit::us_diff(start, blit::now_us());
+
+            int n = 0;
+            vissprite_t *prev = nullptr;
+            for(auto spr = vsprsortedhead.next; spr != &vsprsortedhead; spr = spr->next, n++)
+            {
+                if(prev && (spr->scale < prev->scale || (spr->scale == prev->scale && spr < prev)))
+                    ok = false;
+                prev = spr;
+            }
+
+            if(n != count)
+                ok = false;
+        }
+
+        printf("sprite sort %3i sprites %8.2fus%s\n", count, float(time_us) / iterations, ok ? "" : " WRONG ORDER");
+    }
+
+    vissprites = old_vissprites;
+    vissprite_p = old_vissprite_p;
+}
+
+// renders every frame of DEMO1 with vanilla's linear R_FindPlane and with
+// the hashed one, timing R_RenderPlayerView for each (the rest of the frame
+// is the same work both times). Which goes first alternates, so that neither
+// always finds the composites cached. Both have to draw the same frame from
+// the same number of planes
+static int benchmark_visplanes()
+{
+    static byte first_frame[SCREENWIDTH * SCREENHEIGHT];
+
+    if(W_CheckNumForName((char *)"DEMO1") < 0)
+        return 0;
+
+    uint64_t time_us[2] = {0, 0};
+    int frames = 0, planes = 0, max_planes = 0, mismatches = 0;
+
+    advancedemo = false;
+    nodrawers = true;
+    singletics = true;
+
+    G_DeferedPlayDemo((char *)"DEMO1");
+
+    while(gameaction == ga_playdemo || demoplayback)
+    {
+        TryRunTics();
+
+        if(gamestate != GS_LEVEL)
+            continue;
+
+        if(setsizeneeded)
+            R_ExecuteSetViewSize();
+
+        int old_fuzzpos = fuzzpos, num_planes[2];
+
+        for(int pass = 0; pass < 2; pass++)
+        {
+            fuzzpos = old_fuzzpos;
+            visplanelinear = (pass + frames) % 2 == 0;
+
+            uint32_t start = blit::now_us();
+            R_RenderPlayerView(&players[displayplayer]);
+            time_us[visplanelinear ? 0 : 1] += blit::us_diff(start, blit::now_us());
+
+            num_planes[pass] = lastvisplane - visplanes;
+
+            if(pass == 0)
+                memcpy(first_frame, I_VideoBuffer, sizeof(first_frame));
+        }
+
+        if(num_planes[0] != num_planes[1] || memcmp(first_frame, I_VideoBuffer, sizeof(first_frame)) != 0)
+            mismatches++;
+
+        frames++;
+        planes += num_planes[0];
+        max_planes = std::max(max_planes, num_planes[0]);
+    }
+
+    visplanelinear = false;
+    nodrawers = false;
+    singletics = false;
+
+    if(frames)
+    {
+        printf("visplanes DEMO1: %i frames, %.1f planes avg %i max, view linear %.2fms hashed %.2fms%s\n", frames,
+               float(planes) / frames, max_planes, time_us[0] / 1000.0f / frames, time_us[1] / 1000.0f / frames,
+               mismatches ? " MISMATCH" : "");
+    }
+
+    return mismatches;
+}
+
+// renders every frame of DEMO1 and checks that each sprite gets the same
+// clipping through the drawseg buckets as through the full walk. Then
+// times R_DrawMasked again both ways, alternating which goes first. The
+// masked segs were already drawn by then, so their columns are skipped,
+// the same for both
+static int benchmark_drawsegs()
+{
+    if(W_CheckNumForName((char *)"DEMO1") < 0)
+        return 0;
+
+    uint64_t time_us[2] = {0, 0};
+    int frames = 0, sprites = 0, drawsegs_total = 0, mismatches = 0;
+
+    advancedemo = false;
+    nodrawers = true;
+    singletics = true;
+
+    G_DeferedPlayDemo((char *)"DEMO1");
+
+    while(gameaction == ga_playdemo || demoplayback)
+    {
+        TryRunTics();
+
+        if(gamestate != GS_LEVEL)
+            continue;
+
+        if(setsizeneeded)
+            R_ExecuteSetViewSize();
+
+        R_RenderPlayerView(&players[displayplayer]);
+
+        mismatches += R_CheckSpriteClips();
+
+        for(int pass = 0; pass < 2; pass++)
+        {
+            drawseglinear = (pass + frames) % 2 == 0;
+
+            uint32_t start = blit::now_us();
+            R_DrawMasked();
+            time_us[drawseglinear ? 0 : 1] += blit::us_diff(start, blit::now_us());
+        }
+
+        drawseglinear = false;
+
+        frames++;
+        sprites += vissprite_p - vissprites;
+        drawsegs_total += ds_p - drawsegs;
+    }
+
+    nodrawers = false;
+    singletics = false;
+
+    if(frames)
+    {
+        printf("drawsegs DEMO1: %i frames, %.1f sprites %.1f drawsegs avg, masked full walk %.2fms buckets %.2fms%s\n",
+               frames, float(sprites) / frames, float(drawsegs_total) / frames,
+               time_us[0] / 1000.0f / frames, time_us[1] / 1000.0f / frames,
+               mismatches ? " MISMATCH" : "");
+    }
+
+    return mismatches;
+}
+
+static void map_name(char *name, size_t len, int episode, int map)
+{
+    if(gamemode == commercial)
+        snprintf(name, len, "MAP%02i", map);
+    else
+        snprintf(name, len, "E%iM%i", episode, map);
+}
+
+static int count_monsters()
+{
+    int count = 0;
+
+    for(auto th = thinkercap.next; th != &thinkercap; th = th->next)
+    {
+        if(th->function.acp1 == (actionf_p1)P_MobjThinker && (((mobj_t *)th)->flags & MF_COUNTKILL))
+            count++;
+    }
+
+    return count;
+}
+
+// save and load times on E1M1 (MAP01) and the map of the first episode with
+// the most monsters (UV), with the savegame buffer and with a buffer of one
+// byte, which does a file operation per byte like before there was one.
+// Loading includes setting up the level again, which is timed on its own.
+// The saves go in benchmark/ in the savegame directory
+static void benchmark_savegames()
+{
+    static const int iterations = 5;
+    static const int buffer_sizes[] = {1, 512};
+
+    int num_maps = gamemode == commercial ? 32 : 9;
+    int heaviest = 1, heaviest_monsters = -1;
+    char name[8];
+
+    for(int map = 1; map <= num_maps; map++)
+    {
+        map_name(name, sizeof(name), 1, map);
+        if(W_CheckNumForName(name) < 0)
+            continue;
+
+        G_InitNew(sk_hard, 1, map);
+
+        int monsters = count_monsters();
+        if(monsters > heaviest_monsters)
+        {
+            heaviest = map;
+            heaviest_monsters = monsters;
+        }
+    }
+
+    if(heaviest_monsters < 0)
+        return;
+
+    char *old_savegamedir = savegamedir;
+    std::string dir = std::string(savegamedir) + "benchmark/";
+    M_MakeDirectory((char *)dir.c_str());
+    savegamedir = (char *)dir.c_str();
+
+    int old_buffer_size = savegame_buffer_size;
+
+    int maps[] = {1, heaviest};
+    int num_bench_maps = heaviest == 1 ? 1 : 2;
+
+    for(int m = 0; m < num_bench_maps; m++)
+    {
+        int map = maps[m];
+
+        uint32_t start = blit::now_us();
+        G_InitNew(sk_hard, 1, map);
+        uint32_t setup_us = blit::us_diff(start, blit::now_us());
+
+        map_name(name, sizeof(name), 1, map);
+        int monsters = count_monsters();
+
+        for(int size : buffer_sizes)
+        {
+            uint32_t save_us = 0, load_us = 0;
+
+            savegame_buffer_size = size;
+
+            for(int i = 0; i < iterations; i++)
+            {
+                start = blit::now_us();
+                G_SaveGame(0, (char *)"BENCHMARK");
+                G_DoSaveGame();
+                save_us += blit::us_diff(start, blit::now_us());
+
+                start = blit::now_us();
+                G_LoadGame(P_SaveGameFile(0));
+                G_DoLoadGame();
+                load_us += blit::us_diff(start, blit::now_us());
+            }
+
+            printf("savegame %-5s %3i monsters %3i byte buffer: save %8.2fms load %8.2fms (level setup %.2fms)\n",
+                   name, monsters, size, save_us / 1000.0f / iterations, load_us / 1000.0f / iterations,
+                   setup_us / 1000.0f);
+        }
+    }
+
+    savegame_buffer_size = old_buffer_size;
+    savegamedir = old_savegamedir;
+}
+
+#ifdef FEATURE_TRANSPOSED_VIEW
+// plays part of DEMO1, rendering every tic with the whole view and then in
+// strips of a few widths, and compares the frames. They are not expected to
+// be bit-identical: walls interpolate their scale and flats step their
+// texture coordinates from the edge of each strip, which moves the odd
+// pixel next to a strip boundary. A strip width fails if any screen column
+// of any frame has more than strip_max_column_differ of its view pixels
+// changed. A strip that is clipped or placed wrongly changes most of its
+// columns, even when it is only a few pixels wide and so a tiny part of the
+// frame. Returns the number of widths that failed
+static const float strip_max_column_differ = 0.5f;
+
+static int check_strips()
+{
+    static const int widths[] = {4, 36, 64, 128};
+    static const int num_widths = sizeof(widths) / sizeof(widths[0]);
+    static const int max_frames = 350;
+    static byte golden[SCREENWIDTH * SCREENHEIGHT];
+
+    if(W_CheckNumForName((char *)"DEMO1") < 0)
+        return 0;
+
+    int old_strip_width = strip_width;
+    int frames = 0, differ[num_widths] = {0}, max_pixels[num_widths] = {0};
+    int max_column[num_widths] = {0};
+
+    advancedemo = false;
+    nodrawers = true;
+    singletics = true;
+
+    G_DeferedPlayDemo((char *)"DEMO1");
+
+    while((gameaction == ga_playdemo || demoplayback) && frames < max_frames)
+    {
+        TryRunTics();
+
+        if(gamestate != GS_LEVEL)
+            continue;
+
+        if(setsizeneeded)
+            R_ExecuteSetViewSize();
+
+        // the fuzz effect has its own running position
+        int old_fuzzpos = fuzzpos;
+
+        strip_width = 0;
+        R_RenderPlayerView(&players[displayplayer]);
+        memcpy(golden, I_VideoBuffer, sizeof(golden));
+
+        for(int i = 0; i < num_widths; i++)
+        {
+            fuzzpos = old_fuzzpos;
+            strip_width = widths[i];
+            R_RenderPlayerView(&players[displayplayer]);
+
+            int pixels = 0;
+            for(int x = 0; x < SCREENWIDTH; x++)
+            {
+                int column = 0;
+                for(int y = 0; y < SCREENHEIGHT; y++)
+                {
+                    if(golden[y * SCREENWIDTH + x] != I_VideoBuffer[y * SCREENWIDTH + x])
+                        column++;
+                }
+
+                pixels += column;
+                max_column[i] = std::max(max_column[i], column);
+            }
+
+            if(pixels)
+                differ[i]++;
+
+            max_pixels[i] = std::max(max_pixels[i], pixels);
+        }
+
+        frames++;
+    }
+
+    int failed = 0;
+
+    for(int i = 0; i < num_widths; i++)
+    {
+        bool fail = max_column[i] > strip_max_column_differ * viewheight;
+
+        printf("strips %3i px: %i/%i frames differ, worst %.2f%% of pixels, %i/%i in a column%s\n", widths[i],
+               differ[i], frames, max_pixels[i] * 100.0f / (SCREENWIDTH * SCREENHEIGHT), max_column[i], viewheight,
+               fail ? " FAILED" : "");
+
+        if(fail)
+            failed++;
+    }
+
+    strip_width = old_strip_width;
+    nodrawers = false;
+    singletics = false;
+
+    return failed;
+}
+#endif
+
+// Z_Malloc/Z_Free of thinker sized objects, through the slabs and through
+// the zones, on the first episode's map with the most special lines. As
+// many objects as there are special lines are kept live, freeing one and
+// allocating another at random each time, like doors and lifts starting
+// and finishing, on top of the level's own data
+static void benchmark_slabs()
+{
+    static const int iterations = 20000;
+    static const int sizes[][2] = {
+        {sizeof(mobj_t), PU_LEVEL},
+        {sizeof(vldoor_t), PU_LEVSPEC},
+        {sizeof(plat_t), PU_LEVSPEC},
+        {sizeof(ceiling_t), PU_LEVSPEC},
+        {sizeof(floormove_t), PU_LEVSPEC},
+        {sizeof(lightflash_t), PU_LEVSPEC},
+    };
+    static const int num_sizes = sizeof(sizes) / sizeof(sizes[0]);
+
+    int num_maps = gamemode == commercial ? 32 : 9;
+    int busiest = 0, busiest_specials = 0;
+    char name[8];
+
+    for(int map = 1; map <= num_maps; map++)
+    {
+        map_name(name, sizeof(name), 1, map);
+        if(W_CheckNumForName(name) < 0)
+            continue;
+
+        G_InitNew(sk_hard, 1, map);
+
+        int specials = 0;
+        for(int i = 0; i < numlines; i++)
+        {
+            if(lines[i].special)
+                specials++;
+        }
+
+        if(specials > busiest_specials)
+        {
+            busiest = map;
+            busiest_specials = specials;
+        }
+    }
+
+    if(!busiest)
+        return;
+
+    G_InitNew(sk_hard, 1, busiest);
+    map_name(name, sizeof(name), 1, busiest);
+
+    std::vector<void *> live(busiest_specials);
+
+    for(int slabs = 1; slabs >= 0; slabs--)
+    {
+        noslabs = !slabs;
+        srand(1);
+
+        uint32_t start = blit::now_us();
+
+        for(auto &ptr : live)
+        {
+            auto &size = sizes[rand() % num_sizes];
+            ptr = Z_Malloc(size[0], size[1], NULL);
+        }
+
+        for(int i = 0; i < iterations; i++)
+        {
+            auto &ptr = live[rand() % live.size()];
+            auto &size = sizes[rand() % num_sizes];
+
+            Z_Free(ptr);
+            ptr = Z_Malloc(size[0], size[1], NULL);
+        }
+
+        for(auto &ptr : live)
+            Z_Free(ptr);
+
+        uint32_t time_us = blit::us_diff(start, blit::now_us());
+
+        printf("zone %-5s %4i specials %-5s %8.3fus per malloc and free\n", name, busiest_specials,
+               slabs ? "slabs" : "rover", float(time_us) / (iterations + live.size()));
+    }
+
+    noslabs = false;
+}
+
+// ctest's SKIP_RETURN_CODE, there is nothing to run the demos from without an IWAD
+static const int skip_return_code = 77;
+
+void check_benchmark_iwad()
+{
+    GameMission_t mission;
+
+    if(D_FindIWAD(IWAD_MASK_DOOM, &mission))
+        return;
+
+    printf("no IWAD found, skipping the benchmark\n");
+    exit(skip_return_code);
+}
+
+void run_benchmark()
+{
+    static const char *demos[] = {"DEMO1", "DEMO2", "DEMO3"};
+
+    benchmark_sprite_sort();
+    benchmark_savegames();
+    benchmark_slabs();
+
+    int strip_failures = 0;
+
+#ifdef FEATURE_TRANSPOSED_VIEW
+    strip_failures = check_strips();
+
+    printf("timedemo benchmark (column-major view)\n");
+#else
+    printf("timedemo benchmark (row-major view)\n");
+#endif
+
+#ifdef FEATURE_FAST_LINES
+    printf("fast line_t/seg_t layout (%i/%i bytes)\n", (int)sizeof(line_t), (int)sizeof(seg_t));
+#else
+    printf("lean line_t/seg_t layout (%i/%i bytes)\n", (int)sizeof(line_t), (int)sizeof(seg_t));
+#endif
+
+    // frame times must not change what is drawn
+    adaptive_detail = 0;
+    strip_width = 0;
+
+    // nor can the config, full view at high detail
+    screenblocks = 10;
+    detailLevel = 0;
+    R_SetViewSize(screenblocks, detailLevel);
+
+    int visplane_mismatches = benchmark_visplanes();
+    int clip_mismatches = benchmark_drawsegs();
+
+    // nor can the overlays be in the frames
+#ifdef FEATURE_PROFILER
+    show_profiler = show_zonestats = 0;
+#endif
+
+    load_golden_frames();
+
+    int desyncs = 0;
+
+    for(int draw = 1; draw >= 0; draw--)
+    {
+        BenchmarkResult total;
+
+        for(auto &demo : demos)
+        {
+            if(W_CheckNumForName((char *)demo) < 0)
+                continue;
+
+            BenchmarkResult result;
+            R_ResetCompositeStats();
+
+            // the fuzz effect carries on from whatever was drawn before
+            fuzzpos = 0;
+
+            run_timedemo(demo, draw, result);
+            print_result(demo, draw, result);
+
+            // RAM used by the layout, the level is still loaded
+            if(draw)
+            {
+                char map[8];
+                map_name(map, sizeof(map), gameepisode, gamemap);
+
+                // segs used from a precompiled level are in the WAD
+                int seg_bytes = levelprecompiled ? 0 : numsegs * (int)sizeof(seg_t);
+
+                printf("         %s: %i lines + %i segs%s = %i bytes\n", map,
+                       numlines, numsegs, levelprecompiled ? " (precompiled)" : "",
+                       numlines * (int)sizeof(line_t) + seg_bytes);
+
+                // for sizing composite_cache_kb
+                compositestats_t composites;
+                R_GetCompositeStats(&composites);
+
+                printf("         composites: %u hits %u misses %u regenerated %u evicted, peak %iK of %iK%s\n",
+                       composites.hits, composites.misses, composites.regenerations, composites.evictions,
+                       composites.peakbytes / 1024, composite_cache_kb, composite_columns ? " (by column)" : "");
+            }
+
+            // against <demo>.sum, if there is one
+            if(P_TicSumDiverged())
+                desyncs++;
+
+            total.tics += result.tics;
+            total.time_us += result.time_us;
+            total.min_tic_us = std::min(total.min_tic_us, result.min_tic_us);
+            total.max_tic_us = std::max(total.max_tic_us, result.max_tic_us);
+
+            for(int i = 0; i < num_buckets; i++)
+                total.histogram[i] += result.histogram[i];
+        }
+
+        print_result("total", draw, total);
+    }
+
+    finish_golden_frames();
+
+    if(desyncs)
+        printf("%i demo runs desynced\n", desyncs);
+
+    if(strip_failures)
+        printf("%i strip widths failed\n", strip_failures);
+
+    if(visplane_mismatches)
+        printf("%i frames drawn differently with the linear visplane lookup\n", visplane_mismatches);
+
+    if(clip_mismatches)
+        printf("%i sprites clipped differently through the drawseg buckets\n", clip_mismatches);
+
+    // so that scripts can fail on a rendering or simulation change
+    exit(golden.failed || golden.missing || desyncs || strip_failures || visplane_mismatches || clip_mismatches ? 1 : 0);
+}
@@ -7,11 +7,17 @@
 #endif
 
 #include "../chocdoom/doomstat.h"
+#include "../chocdoom/m_profile.h"
 #include "../chocdoom/s_sound.h"
 
 extern void D_DoomMain();
 extern void D_Display();
 
+#ifdef DOOM_BENCHMARK
+extern void check_benchmark_iwad();
+extern void run_benchmark();
+#endif
+
 #ifdef TARGET_32BLIT_HW
 extern "C" void *_sbrk(ptrdiff_t incr)
 {
@@ -39,6 +45,12 @@ jmp_buf jump_buffer;
 std::string fatal_error;
 void blit_die(const char *msg)
 {
+#ifdef DOOM_BENCHMARK
+    // nobody to look at the error screen, fail the run
+    printf("%s\n", msg);
+    exit(1);
+#endif
+
     fatal_error = msg;
     fatal_error = blit::screen.wrap_text(fatal_error, blit::screen.bounds.w - 20, blit::minimal_font);
 
@@ -118,12 +130,20 @@ void update(uint32_t time)
         return;
 
     if(!done_init) {
+#ifdef DOOM_BENCHMARK
+        check_benchmark_iwad();
+#endif
         D_DoomMain();
         done_init = true;
+#ifdef DOOM_BENCHMARK
+        run_benchmark();
+#endif
         return;
     }
 
+    PROFILE_BEGIN(prof_tics);
     TryRunTics();
+    PROFILE_END(prof_tics);
 	S_UpdateSounds(players[consoleplayer].mo);
 }
 
@@ -1136,8 +1136,8 @@ void AM_drawWalls(void)
 	    if ((lines[i].flags & LINE_NEVERSEE) && !cheating)
 		continue;
 
-        sector_t *frontsector = lines[i].sidenum[0] == -1 ? 0 : sides[lines[i].sidenum[0]].sector;
-        sector_t *backsector = lines[i].sidenum[1] == -1 ? 0 : sides[lines[i].sidenum[1]].sector;
+        sector_t *frontsector = LINE_FRONTSECTOR(&lines[i]);
+        sector_t *backsector = LINE_BACKSECTOR(&lines[i]);
 
 	    if (!backsector)
 	    {
@@ -50,6 +50,7 @@
 #include "m_controls.h"
 #include "m_misc.h"
 #include "m_menu.h"
+#include "m_profile.h"
 #include "p_saveg.h"
 
 #include "i_endoom.h"
@@ -185,6 +186,11 @@ void D_Display (void)
 
     if (nodrawers)
     	return;                    // for comparative timing / profiling
+
+    M_ProfileFrame ();
+
+    R_AdaptDetail (gamestate == GS_LEVEL && gametic && !automapactive
+                   && !menuactive && !paused);
 		
     redrawsbar = false;
     
@@ -216,36 +222,62 @@ void D_Display (void)
 			break;
 		if (automapactive)
 			AM_Drawer ();
-		if (wipe || (viewheight != 200 && fullscreen) )
+		if (wipe || (viewheight != SCREENHEIGHT && fullscreen) )
 			redrawsbar = true;
 		if (inhelpscreensstate && !inhelpscreens)
 			redrawsbar = true;              // just put away the help screen
-		ST_Drawer (viewheight == 200, redrawsbar );
-		fullscreen = viewheight == 200;
+		PROFILE_BEGIN(prof_statusbar);
+		ST_Drawer (viewheight == SCREENHEIGHT, redrawsbar );
+		PROFILE_END(prof_statusbar);
+		fullscreen = viewheight == SCREENHEIGHT;
 		break;
 
       case GS_INTERMISSION:
+		V_SetYOffset (ORIGYOFFSET);
 		WI_Drawer ();
+		V_SetYOffset (0);
 		break;
 
       case GS_FINALE:
+		V_SetYOffset (ORIGYOFFSET);
 		F_Drawer ();
+		V_SetYOffset (0);
 		break;
 
       case GS_DEMOSCREEN:
+		V_SetYOffset (ORIGYOFFSET);
 		D_PageDrawer ();
+		V_SetYOffset (0);
 		break;
     }
+
+#ifdef FEATURE_NATIVE_SCREEN
+    // blank the lines above and below 320x200 screens
+    if (gamestate != GS_LEVEL || inhelpscreens)
+    {
+		V_DrawFilledBox (0, 0, SCREENWIDTH, ORIGYOFFSET, 0);
+		V_DrawFilledBox (0, ORIGYOFFSET + ORIGHEIGHT, SCREENWIDTH, ORIGYOFFSET, 0);
+    }
+#endif
     
     // draw buffered stuff to screen
     I_UpdateNoBlit ();
     
     // draw the view directly
     if (gamestate == GS_LEVEL && !automapactive && gametic)
+    {
     	R_RenderPlayerView (&players[displayplayer]);
+    	V_MarkRect (viewwindowx, viewwindowy, scaledviewwidth, viewheight);
+    }
 
     if (gamestate == GS_LEVEL && gametic)
+    {
+    	PROFILE_BEGIN(prof_hud);
     	HU_Drawer ();
+    	PROFILE_END(prof_hud);
+    }
+
+    M_ProfileDrawer ();
     
     // clean up border stuff
     if (gamestate != oldgamestate && gamestate != GS_LEVEL)
@@ -295,7 +327,9 @@ void D_Display (void)
 
 
     // menus go directly to the screen
+    V_SetYOffset (ORIGYOFFSET);
     M_Drawer ();          // menu is drawn even on top of everything
+    V_SetYOffset (0);
     NetUpdate ();         // send out any new accumulation
 
 
@@ -372,6 +406,17 @@ void D_BindVariables(void)
     M_BindVariable("vanilla_savegame_limit", &vanilla_savegame_limit);
     M_BindVariable("vanilla_demo_limit",     &vanilla_demo_limit);
     M_BindVariable("show_endoom",            &show_endoom);
+    M_BindVariable("adaptive_detail",        &adaptive_detail);
+    M_BindVariable("adaptive_fps",           &adaptive_fps);
+    M_BindVariable("adaptive_shrink",        &adaptive_shrink);
+    M_BindVariable("strip_width",            &strip_width);
+    M_BindVariable("composite_cache_kb",     &composite_cache_kb);
+    M_BindVariable("composite_columns",      &composite_columns);
+#ifdef FEATURE_PROFILER
+    M_BindVariable("show_profiler",          &show_profiler);
+    M_BindVariable("profiler_csv",           &profiler_csv);
+    M_BindVariable("show_zonestats",         &show_zonestats);
+#endif
 
     // Multiplayer chat macros
 
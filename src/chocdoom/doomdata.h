@@ -49,7 +49,8 @@ enum
   ML_NODES,		// BSP nodes
   ML_SECTORS,		// Sectors, from editing
   ML_REJECT,		// LUT, sector-sector visibility	
-  ML_BLOCKMAP		// LUT, motion clipping, walls/grid element
+  ML_BLOCKMAP,		// LUT, motion clipping, walls/grid element
+  ML_PRECOMP		// optional, precompiled level (append_wads.py)
 };
 
 
@@ -207,6 +208,23 @@ typedef struct
 } PACKEDATTR mapthing_t;
 
 
+// Header of a PRECOMP lump, the vertexes and segs of a level already
+// converted to vertex_t and seg_t. Offsets are from the start of the
+// lump and 4 byte aligned, as is the lump itself in the file, so that
+// a memory-mapped WAD can be used in place.
+#define PRECOMP_VERSION		1
+
+typedef struct
+{
+    char		magic[4];	// "PLVL"
+    int			version;
+    int			vertexsize;	// sizeof(vertex_t)
+    int			segsize;	// sizeof(seg_t)
+    int			numvertexes;
+    int			vertexesofs;
+    int			numsegs;
+    int			segsofs;
+} PACKEDATTR precomplevel_t;
 
 
 
@@ -35,6 +35,40 @@
 
 #undef FEATURE_SOUND
 
+// Enables the frame profiler (show_profiler / profiler_csv) and the
+// zone usage overlay (show_zonestats)
+
+#define FEATURE_PROFILER
+
+// Renders straight into the 320x240 screen instead of a 320x200 buffer
+// that is stretched to fit every frame. The 3D view gets a taller
+// projection to keep the 4:3 aspect, 320x200 screens are centred
+
+#undef FEATURE_NATIVE_SCREEN
+
+// Checksums the play simulation after every tic, writing the sums to
+// x.sum when recording demo x.lmp and reporting the first tic that does
+// not match when playing it back with x.sum present
+
+#undef FEATURE_TIC_CHECKSUM
+
+// Draws the 3D view column-major into a buffer of its own, which is
+// transposed onto the screen when the view is finished. Defined by the
+// build (the TRANSPOSED_VIEW cmake option), so that the benchmark can be
+// built with both layouts
+
+//#define FEATURE_TRANSPOSED_VIEW
+
+// Keeps dx/dy and the front/back sectors in line_t instead of working them
+// out on every access (LINE_DX() etc.), which costs 16 bytes per line.
+// seg_t always has its front sector, as an index, so that precompiled segs
+// (which take no RAM) are the same in both builds.
+// Defined by the build (the FAST_LINES cmake option),
+// doom-benchmark-fastlines prints the cost for each demo's map next to
+// the timings
+
+//#define FEATURE_FAST_LINES
+
 #endif /* #ifndef DOOM_FEATURES_H */
 
 
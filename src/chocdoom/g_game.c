@@ -34,6 +34,7 @@
 #include "m_controls.h"
 #include "m_misc.h"
 #include "m_menu.h"
+#include "m_profile.h"
 #include "m_random.h"
 #include "i_system.h"
 #include "i_timer.h"
@@ -42,6 +43,7 @@
 #include "p_setup.h"
 #include "p_saveg.h"
 #include "p_tick.h"
+#include "p_ticsum.h"
 
 #include "d_main.h"
 
@@ -635,6 +637,11 @@ void G_DoLoadLevel (void)
     displayplayer = consoleplayer;		// view the guy you are playing    
     gameaction = ga_nothing; 
     Z_CheckHeap ();
+
+    // peaks cover the previous level as well as loading this one
+    printf ("G_DoLoadLevel: E%iM%i memory\n", gameepisode, gamemap);
+    Z_DumpStats ();
+    Z_ResetPeaks ();
     
     // clear cmd building stuff
 
@@ -984,7 +991,10 @@ void G_Ticker (void)
     switch (gamestate) 
     { 
       case GS_LEVEL: 
+	PROFILE_BEGIN(prof_ticker);
 	P_Ticker (); 
+	PROFILE_END(prof_ticker);
+	P_TicSumTic ();
 	ST_Ticker (); 
 	AM_Ticker (); 
 	HU_Ticker ();            
@@ -1536,9 +1546,7 @@ void G_DoLoadGame (void)
     	return;
     }
 
-    save_stream_off = 0;
-
-    savegame_error = false;
+    P_ResetSaveGameStream();
 
     if (!P_ReadSaveGameHeader())
     {
@@ -1606,9 +1614,7 @@ void G_DoSaveGame (void)
     	I_Error ("open err %s\n", temp_savegame_file);
     }
 
-    save_stream_off = 0;
-
-    savegame_error = false;
+    P_ResetSaveGameStream();
 
     P_WriteSaveGameHeader(savedescription);
  
@@ -1629,6 +1635,7 @@ void G_DoSaveGame (void)
     
     // Finish up, close the savegame file.
 
+    P_FlushSaveGameStream();
     save_stream.close();
 
     // Now rename the temporary savegame file to the actual savegame
@@ -2002,6 +2009,24 @@ int G_VanillaVersionCode(void)
     }
 }
 
+#ifdef FEATURE_TIC_CHECKSUM
+
+// The checksums for demo x.lmp are kept in x.sum
+
+static char *TicSumName(char *name)
+{
+    char *result = M_StringJoin(name, ".sum", NULL);
+
+    if (M_StringEndsWith(name, ".lmp"))
+    {
+        M_StringCopy(result + strlen(name) - 4, ".sum", 5);
+    }
+
+    return result;
+}
+
+#endif
+
 void G_BeginRecording (void) 
 { 
     int             i; 
@@ -2042,6 +2067,14 @@ void G_BeginRecording (void)
 	 
     for (i=0 ; i<MAXPLAYERS ; i++) 
 	*demo_p++ = playeringame[i]; 		 
+
+#ifdef FEATURE_TIC_CHECKSUM
+    {
+        char *sumname = TicSumName(demoname);
+        P_TicSumRecord(sumname);
+        free(sumname);
+    }
+#endif
 } 
  
 
@@ -2158,6 +2191,14 @@ void G_DoPlayDemo (void)
     precache = true; 
     starttime = I_GetTime (); 
 
+#ifdef FEATURE_TIC_CHECKSUM
+    {
+        char *sumname = TicSumName(defdemoname);
+        P_TicSumPlayback(sumname);
+        free(sumname);
+    }
+#endif
+
     usergame = false; 
     demoplayback = true; 
 } 
@@ -2210,6 +2251,8 @@ boolean G_CheckDemoStatus (void)
         timingdemo = false;
         demoplayback = false;
 
+        P_TicSumEnd();
+
 	I_Error ("timed %i gametics in %i realtics (%f fps)",
                  gametic, realtics, (double)fps);
     } 
@@ -2217,6 +2260,7 @@ boolean G_CheckDemoStatus (void)
     if (demoplayback) 
     { 
         W_ReleaseLumpName(defdemoname);
+        P_TicSumEnd();
 	demoplayback = false; 
 	netdemo = false;
 	netgame = false;
@@ -2241,6 +2285,7 @@ boolean G_CheckDemoStatus (void)
     { 
 	*demo_p++ = DEMOMARKER; 
 	M_WriteFile (demoname, demobuffer, demo_p - demobuffer); 
+	P_TicSumEnd();
 	Z_Free (demobuffer); 
 	demorecording = false; 
 	I_Error ("Demo %s recorded",demoname); 
@@ -22,10 +22,13 @@
 #include <stdlib.h>
 #include <string.h>
 
+#include "config.h"
 #include "doomtype.h"
 
+#include "i_swap.h"
 #include "i_video.h"
 #include "m_argv.h"
+#include "w_file.h"
 #include "z_zone.h"
 
 #if defined(_MSC_VER) && !defined(__cplusplus)
@@ -44,6 +47,15 @@ static byte *dest_buffer;
 
 static int dest_pitch;
 
+// Lines of src_buffer that changed since the last update (dirtylines),
+// or NULL to always update everything. Only the 1x stretch uses this.
+
+static byte *dirty_lines = NULL;
+
+// Output lines written and skipped by the last update
+
+static int lines_written, lines_skipped;
+
 // Lookup tables used for aspect ratio correction stretching code.
 // stretch_tables[0] : 20% / 80%
 // stretch_tables[1] : 40% / 60%
@@ -51,6 +63,25 @@ static int dest_pitch;
 
 static byte *stretch_tables[2] = { NULL, NULL };
 
+// Precomputed stretch tables written by append_wads.py. If the tables
+// for the current palette are in here, stretch_tables point into the
+// mapped file instead of zone memory.
+
+#define STRETCH_TABLES_FILE FILES_DIR "/stretch.tbl"
+
+typedef struct
+{
+    // Should be "STRT"
+    char identification[4];
+    int numpalettes;
+    // followed by numpalettes * (palette[256 * 3], table_20[256 * 256], table_40[256 * 256])
+} PACKEDATTR stretchtablesheader_t;
+
+#define STRETCH_TABLES_ENTRY_SIZE (256 * 3 + 256 * 256 * 2)
+
+static wad_file_t *stretch_tables_file = NULL;
+static boolean stretch_tables_mapped = false;
+
 // 50%/50% stretch table, for 800x600 squash mode
 
 static byte *half_stretch_table = NULL;
@@ -65,6 +96,20 @@ void I_InitScale(byte *_src_buffer, byte *_dest_buffer, int _dest_pitch)
     dest_pitch = _dest_pitch;
 }
 
+void I_SetScaleDirtyLines(byte *_dirty_lines)
+{
+    dirty_lines = _dirty_lines;
+}
+
+// Percentage of output lines that the last update did not need to write
+
+int I_GetScaleSkipped(void)
+{
+    int total = lines_written + lines_skipped;
+
+    return total ? lines_skipped * 100 / total : 0;
+}
+
 //
 // Pixel doubling scale-up functions.
 //
@@ -355,6 +400,58 @@ static byte *GenerateStretchTable(byte *palette, int pct)
     return result;
 }
 
+// Look for precomputed tables for this palette. Returns true if found.
+
+static boolean MapStretchTables(byte *palette)
+{
+    stretchtablesheader_t *header;
+    byte *entry;
+    int numpalettes;
+    int i;
+
+    if (stretch_tables_file == NULL)
+    {
+        stretch_tables_file = W_OpenFile(STRETCH_TABLES_FILE);
+
+        if (stretch_tables_file == NULL)
+        {
+            return false;
+        }
+    }
+
+    // we only want this if it's free
+    if (stretch_tables_file->mapped == NULL
+     || stretch_tables_file->length < sizeof(stretchtablesheader_t))
+    {
+        return false;
+    }
+
+    header = (stretchtablesheader_t *) stretch_tables_file->mapped;
+    numpalettes = LONG(header->numpalettes);
+
+    if (strncmp(header->identification, "STRT", 4)
+     || stretch_tables_file->length < sizeof(stretchtablesheader_t)
+                                    + numpalettes * STRETCH_TABLES_ENTRY_SIZE)
+    {
+        return false;
+    }
+
+    entry = stretch_tables_file->mapped + sizeof(stretchtablesheader_t);
+
+    for (i = 0; i < numpalettes; ++i, entry += STRETCH_TABLES_ENTRY_SIZE)
+    {
+        if (!memcmp(entry, palette, 256 * 3))
+        {
+            stretch_tables[0] = entry + 256 * 3;
+            stretch_tables[1] = entry + 256 * 3 + 256 * 256;
+            stretch_tables_mapped = true;
+            return true;
+        }
+    }
+
+    return false;
+}
+
 // Called at startup to generate the lookup tables for aspect ratio
 // correcting scale up.
 
@@ -374,6 +471,12 @@ static void I_InitStretchTables(byte *palette)
     // mix 80%  =  stretch_tables[0] used backwards
     // mix 100% =  just write line 2
 
+    if (MapStretchTables(palette))
+    {
+        printf("I_InitStretchTables: Using precomputed lookup tables\n");
+        return;
+    }
+
     printf("I_InitStretchTables: Generating lookup tables..");
     fflush(stdout);
     stretch_tables[0] = GenerateStretchTable(palette, 20);
@@ -405,12 +508,24 @@ void I_ResetScaleTables(byte *palette)
 {
     if (stretch_tables[0] != NULL)
     {
-        Z_Free(stretch_tables[0]);
-        Z_Free(stretch_tables[1]);
+        if (!stretch_tables_mapped)
+        {
+            Z_Free(stretch_tables[0]);
+            Z_Free(stretch_tables[1]);
+        }
 
-        printf("I_ResetScaleTables: Regenerating lookup tables..\n");
-        stretch_tables[0] = GenerateStretchTable(palette, 20);
-        stretch_tables[1] = GenerateStretchTable(palette, 40);
+        stretch_tables_mapped = false;
+
+        if (MapStretchTables(palette))
+        {
+            printf("I_ResetScaleTables: Using precomputed lookup tables\n");
+        }
+        else
+        {
+            printf("I_ResetScaleTables: Regenerating lookup tables..\n");
+            stretch_tables[0] = GenerateStretchTable(palette, 20);
+            stretch_tables[1] = GenerateStretchTable(palette, 40);
+        }
     }
 
     if (half_stretch_table != NULL)
@@ -464,11 +579,28 @@ static boolean I_Stretch1x(int x1, int y1, int x2, int y2)
     bufp = src_buffer + y1 * SCREENWIDTH + x1;
     screenp = (byte *) dest_buffer + y1 * dest_pitch + x1;
 
+    lines_written = lines_skipped = 0;
+
     // For every 5 lines of src_buffer, 6 lines are written to dest_buffer
     // (200 -> 240)
 
     for (y=0; y<SCREENHEIGHT; y += 5)
     {
+        // Each group of 6 output lines is only blended from its own 5
+        // source lines, so it can be left alone if none of them changed
+
+        if (dirty_lines != NULL
+         && !(dirty_lines[y] | dirty_lines[y + 1] | dirty_lines[y + 2]
+            | dirty_lines[y + 3] | dirty_lines[y + 4]))
+        {
+            screenp += dest_pitch * 6;
+            bufp += SCREENWIDTH * 5;
+            lines_skipped += 6;
+            continue;
+        }
+
+        lines_written += 6;
+
         // 100% line 0
         memcpy(screenp, bufp, SCREENWIDTH);
         screenp += dest_pitch;
@@ -24,6 +24,8 @@
 
 void I_InitScale(byte *_src_buffer, byte *_dest_buffer, int _dest_pitch);
 void I_ResetScaleTables(byte *palette);
+void I_SetScaleDirtyLines(byte *_dirty_lines);
+int I_GetScaleSkipped(void);
 
 // Scaled modes (direct multiples of 320x200)
 
@@ -20,6 +20,10 @@
 #include "SDL.h"
 #endif
 
+#ifndef TARGET_32BLIT_HW
+#include <chrono>
+#endif
+
 #include "i_timer.h"
 #include "doomtype.h"
 
@@ -123,6 +127,20 @@ int I_GetTimeMS(void)
     return ticks - basetime;
 }
 
+//
+// Time in microseconds, for profiling. Only useful for differences.
+//
+
+unsigned int I_GetTimeUS(void)
+{
+#ifdef TARGET_32BLIT_HW
+    return blit::now_us();
+#else
+    return std::chrono::duration_cast<std::chrono::microseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
 // Sleep for a specified number of ms
 
 void I_Sleep(int ms)
@@ -28,6 +28,7 @@ rcsid[] = "$Id: i_x.c,v 1.6 1997/02/03 22:45:10 b1 Exp $";
 #include "config.h"
 #include "v_video.h"
 #include "m_argv.h"
+#include "m_profile.h"
 #include "d_event.h"
 #include "d_main.h"
 #include "i_video.h"
@@ -111,17 +112,30 @@ static bool run;
 
 void I_InitGraphics (void)
 {
+#ifdef FEATURE_NATIVE_SCREEN
+	// draw straight into the screen, there is nothing to scale
+	I_VideoBuffer = blit::screen.ptr(0, 0);
+
+	screenvisible = true;
+#else
 	I_VideoBuffer = (byte*)Z_Malloc (SCREENWIDTH * SCREENHEIGHT, PU_STATIC, NULL);
 
 	screenvisible = true;
 
 	if(screen_mode->InitMode)
 		screen_mode->InitMode((byte *)W_CacheLumpName(DEH_String("PLAYPAL"), PU_CACHE));
+
+	// only the lines drawn to since the last update are stretched
+	I_SetScaleDirtyLines(dirtylines);
+	V_MarkAllDirty();
+#endif
 }
 
 void I_ShutdownGraphics (void)
 {
+#ifndef FEATURE_NATIVE_SCREEN
 	Z_Free (I_VideoBuffer);
+#endif
 }
 
 void I_StartFrame (void)
@@ -182,8 +196,13 @@ void I_FinishUpdate (void)
 	if(!palette)
 		return;
 
+#ifndef FEATURE_NATIVE_SCREEN
+	PROFILE_BEGIN(prof_finishupdate);
 	I_InitScale(I_VideoBuffer, blit::screen.ptr(0, 0), SCREENWIDTH);
 	screen_mode->DrawScreen(0, 0, SCREENWIDTH, SCREENHEIGHT);
+	V_ClearDirty();
+	PROFILE_END(prof_finishupdate);
+#endif
 }
 
 //
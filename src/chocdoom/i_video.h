@@ -20,12 +20,23 @@
 #ifndef __I_VIDEO__
 #define __I_VIDEO__
 
+#include "doomfeatures.h"
 #include "doomtype.h"
 
 // Screen width and height.
 
 #define SCREENWIDTH  320
+#ifdef FEATURE_NATIVE_SCREEN
+#define SCREENHEIGHT 240
+#else
 #define SCREENHEIGHT 200
+#endif
+
+// Height of the fullscreen graphics (titlepic, intermission, menus),
+// which are drawn ORIGYOFFSET lines down so that they stay centred
+
+#define ORIGHEIGHT 200
+#define ORIGYOFFSET ((SCREENHEIGHT - ORIGHEIGHT) / 2)
 
 // Screen width used for "squash" scale functions
 
@@ -827,6 +827,72 @@ static default_t extra_defaults_list[] =
 
     CONFIG_VARIABLE_INT(show_endoom),
 
+    //!
+    // If non-zero, switch to low detail when frames keep taking longer
+    // than adaptive_fps allows, and back once there is time to spare.
+    //
+
+    CONFIG_VARIABLE_INT(adaptive_detail),
+
+    //!
+    // Frame rate that adaptive_detail tries to hold.
+    //
+
+    CONFIG_VARIABLE_INT(adaptive_fps),
+
+    //!
+    // Number of screen blocks that adaptive_detail may shrink the view
+    // by once it is already at low detail.
+    //
+
+    CONFIG_VARIABLE_INT(adaptive_shrink),
+
+    //!
+    // If non-zero, the 3D view is drawn in vertical strips this many
+    // pixels wide, each in fast memory. Only used by builds with the
+    // column-major view (TRANSPOSED_VIEW).
+    //
+
+    CONFIG_VARIABLE_INT(strip_width),
+
+    //!
+    // Memory in KiB that multi-patch wall textures are kept in once
+    // they have been composited. When it is full, or other allocations
+    // need the memory, the textures drawn the longest ago are dropped,
+    // and all of them are at the start of each level. If zero, they are
+    // dropped whenever the zone needs the memory.
+    //
+
+    CONFIG_VARIABLE_INT(composite_cache_kb),
+
+    //!
+    // If non-zero, only the columns of a multi-patch wall texture that
+    // are drawn get composited, instead of the whole texture at once.
+    //
+
+    CONFIG_VARIABLE_INT(composite_columns),
+
+    //!
+    // If non-zero, the frame profiler overlay is displayed, showing the
+    // min/avg/max time spent in each stage of the frame in ms.
+    //
+
+    CONFIG_VARIABLE_INT(show_profiler),
+
+    //!
+    // If non-zero, the frame profiler writes the time spent in each
+    // stage of every frame (in us) to profile.csv.
+    //
+
+    CONFIG_VARIABLE_INT(profiler_csv),
+
+    //!
+    // If non-zero, an overlay showing the memory in use, its
+    // high-water mark and the fragmentation of each zone is displayed.
+    //
+
+    CONFIG_VARIABLE_INT(show_zonestats),
+
     //!
     // If non-zero, save screenshots in PNG format.
     //
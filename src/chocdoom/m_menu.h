@@ -51,6 +51,9 @@ void M_Init (void);
 // does nothing if menu is already up.
 void M_StartControlPanel (void);
 
+// Write a string using the hu_font
+void M_WriteText(int x, int y, const char *string);
+
 
 
 extern int detailLevel;
@@ -0,0 +1,384 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      Per-stage frame profiler.
+//      Each stage accumulates its time over a frame (a stage can run
+//      more than once, e.g. several tics), which is kept for the last
+//      PROFILE_WINDOW frames for the overlay and optionally written
+//      out as CSV.
+//      The zone overlay also shows the composite texture cache.
+//
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "doomstat.h"
+#include "i_system.h"
+#include "i_video.h"
+#include "i_scale.h"
+#include "i_timer.h"
+#include "m_menu.h"
+#include "m_misc.h"
+#include "m_profile.h"
+#include "r_data.h"
+#include "z_zone.h"
+
+#include "ff.h"
+
+#ifdef FEATURE_PROFILER
+
+// If non-zero, draw the overlay
+int show_profiler = 0;
+
+// If non-zero, write the stage times for each frame to profile.csv
+int profiler_csv = 0;
+
+// If non-zero, draw the zone usage overlay
+int show_zonestats = 0;
+
+#define PROFILE_WINDOW 32
+
+typedef struct
+{
+    const char *name;
+    unsigned int start;
+    unsigned int frame_time;
+    unsigned int history[PROFILE_WINDOW];
+} profstageinfo_t;
+
+static profstageinfo_t stages[NUMPROFSTAGES] =
+{
+    {"TICS"},
+    {"TICKER"},
+    {"BSP"},
+    {"PLANES"},
+    {"MASKED"},
+#ifdef FEATURE_TRANSPOSED_VIEW
+    {"TRANSP"},
+#endif
+    {"STBAR"},
+    {"HUD"},
+    {"UPDATE"},
+    {"FRAME"},
+};
+
+// Percentage of output lines I_FinishUpdate did not need to stretch
+
+static unsigned int skipped_history[PROFILE_WINDOW];
+
+// Event for the current frame's CSV line, and the last one for the overlay
+
+static char frame_event[48];
+static char last_event[48];
+
+static int history_pos = 0;
+static int history_len = 0;
+
+static unsigned int frame_count = 0;
+static boolean frame_started = false;
+
+// CSV output, buffered so that we're not writing to the file every frame
+
+#define CSV_BUFFER_SIZE 1024
+
+static blit::File csv_file;
+static boolean csv_failed = false;
+static uint32_t csv_offset = 0;
+static char csv_buffer[CSV_BUFFER_SIZE];
+static int csv_buffer_len = 0;
+static boolean csv_atexit = false;
+
+void M_ProfileBegin(profstage_t stage)
+{
+    stages[stage].start = I_GetTimeUS();
+}
+
+void M_ProfileEnd(profstage_t stage)
+{
+    stages[stage].frame_time += I_GetTimeUS() - stages[stage].start;
+}
+
+static void FlushCSV(void)
+{
+    csv_file.write(csv_offset, csv_buffer_len, csv_buffer);
+    csv_offset += csv_buffer_len;
+    csv_buffer_len = 0;
+}
+
+// When profiler_csv is turned off, and at exit so that the last rows
+// aren't lost
+static void CloseCSV(void)
+{
+    if (csv_file.is_open())
+    {
+        FlushCSV();
+        csv_file.close();
+
+        // reopening truncates the file
+        csv_offset = 0;
+    }
+}
+
+static void WriteCSV(void)
+{
+    char line[192];
+    int len;
+    int i;
+
+    if (csv_failed)
+    {
+        return;
+    }
+
+    if (!csv_file.is_open())
+    {
+        char *filename = M_StringJoin(savegamedir, "profile.csv", NULL);
+
+        if (!csv_file.open(filename, blit::OpenMode::write))
+        {
+            printf("M_ProfileFrame: failed to open %s\n", filename);
+            free(filename);
+            csv_failed = true;
+            return;
+        }
+
+        free(filename);
+
+        if (!csv_atexit)
+        {
+            I_AtExit(CloseCSV, true);
+            csv_atexit = true;
+        }
+
+        len = M_snprintf(line, sizeof(line), "frame");
+        for (i = 0; i < NUMPROFSTAGES; ++i)
+        {
+            len += M_snprintf(line + len, sizeof(line) - len, ",%s", stages[i].name);
+        }
+
+        len += M_snprintf(line + len, sizeof(line) - len, ",SKIPPED,EVENT");
+
+        memcpy(csv_buffer, line, len);
+        csv_buffer[len] = '\n';
+        csv_buffer_len = len + 1;
+    }
+
+    len = M_snprintf(line, sizeof(line), "%u", frame_count);
+    for (i = 0; i < NUMPROFSTAGES; ++i)
+    {
+        len += M_snprintf(line + len, sizeof(line) - len, ",%u", stages[i].frame_time);
+    }
+
+    len += M_snprintf(line + len, sizeof(line) - len, ",%u,%s", skipped_history[history_pos], frame_event);
+
+    if (csv_buffer_len + len + 1 > CSV_BUFFER_SIZE)
+    {
+        FlushCSV();
+    }
+
+    memcpy(csv_buffer + csv_buffer_len, line, len);
+    csv_buffer[csv_buffer_len + len] = '\n';
+    csv_buffer_len += len + 1;
+}
+
+void M_ProfileFrame(void)
+{
+    int i;
+
+    if (frame_started)
+    {
+        M_ProfileEnd(prof_frame);
+
+        for (i = 0; i < NUMPROFSTAGES; ++i)
+        {
+            stages[i].history[history_pos] = stages[i].frame_time;
+        }
+
+        skipped_history[history_pos] = I_GetScaleSkipped();
+
+        if (profiler_csv)
+        {
+            WriteCSV();
+        }
+        else
+        {
+            CloseCSV();
+        }
+
+        frame_event[0] = '\0';
+
+        history_pos = (history_pos + 1) % PROFILE_WINDOW;
+
+        if (history_len < PROFILE_WINDOW)
+        {
+            history_len++;
+        }
+
+        frame_count++;
+    }
+
+    for (i = 0; i < NUMPROFSTAGES; ++i)
+    {
+        stages[i].frame_time = 0;
+    }
+
+    frame_started = true;
+    M_ProfileBegin(prof_frame);
+}
+
+void M_ProfileEvent(const char *event)
+{
+    M_StringCopy(frame_event, event, sizeof(frame_event));
+    M_StringCopy(last_event, event, sizeof(last_event));
+}
+
+static int DrawStages(int y)
+{
+    char buf[32];
+    int i, j;
+
+    M_WriteText(52, y, "MIN");
+    M_WriteText(80, y, "AVG");
+    M_WriteText(108, y, "MAX");
+    y += 8;
+
+    for (i = 0; i < NUMPROFSTAGES; ++i)
+    {
+        unsigned int min = ~0u, max = 0, total = 0;
+
+        for (j = 0; j < history_len; ++j)
+        {
+            unsigned int time = stages[i].history[j];
+
+            if (time < min)
+                min = time;
+            if (time > max)
+                max = time;
+
+            total += time;
+        }
+
+        M_WriteText(4, y, stages[i].name);
+
+        // in ms, to 0.1ms
+        M_snprintf(buf, sizeof(buf), "%u.%u", min / 1000, (min / 100) % 10);
+        M_WriteText(52, y, buf);
+        M_snprintf(buf, sizeof(buf), "%u.%u", total / history_len / 1000, (total / history_len / 100) % 10);
+        M_WriteText(80, y, buf);
+        M_snprintf(buf, sizeof(buf), "%u.%u", max / 1000, (max / 100) % 10);
+        M_WriteText(108, y, buf);
+
+        y += 8;
+    }
+
+    // lines skipped by the stretch, in %
+    {
+        unsigned int min = ~0u, max = 0, total = 0;
+
+        for (j = 0; j < history_len; ++j)
+        {
+            unsigned int skipped = skipped_history[j];
+
+            if (skipped < min)
+                min = skipped;
+            if (skipped > max)
+                max = skipped;
+
+            total += skipped;
+        }
+
+        M_WriteText(4, y, "SKIP");
+
+        M_snprintf(buf, sizeof(buf), "%u%%", min);
+        M_WriteText(52, y, buf);
+        M_snprintf(buf, sizeof(buf), "%u%%", total / history_len);
+        M_WriteText(80, y, buf);
+        M_snprintf(buf, sizeof(buf), "%u%%", max);
+        M_WriteText(108, y, buf);
+
+        y += 8;
+    }
+
+    if (last_event[0] != '\0')
+    {
+        M_WriteText(4, y, last_event);
+        y += 8;
+    }
+
+    return y;
+}
+
+// in use/size, high-water mark, largest free block (all in KB) and
+// fragmentation for each zone, then the composite texture cache
+static void DrawZoneStats(int y)
+{
+    zonestats_t stats;
+    compositestats_t composites;
+    char buf[32];
+    int i;
+
+    M_WriteText(36, y, "USED");
+    M_WriteText(100, y, "PEAK");
+    M_WriteText(136, y, "FREE");
+    M_WriteText(172, y, "FRAG");
+    y += 8;
+
+    for (i = 0; i < Z_NumZones(); ++i)
+    {
+        Z_GetZoneStats(i, &stats);
+
+        M_WriteText(4, y, Z_ZoneName(i));
+
+        M_snprintf(buf, sizeof(buf), "%i/%iK", stats.used / 1024, stats.size / 1024);
+        M_WriteText(36, y, buf);
+        M_snprintf(buf, sizeof(buf), "%iK", stats.peak / 1024);
+        M_WriteText(100, y, buf);
+        M_snprintf(buf, sizeof(buf), "%iK", stats.largest_free / 1024);
+        M_WriteText(136, y, buf);
+        M_snprintf(buf, sizeof(buf), "%i%%", stats.fragmentation);
+        M_WriteText(172, y, buf);
+
+        y += 8;
+    }
+
+    R_GetCompositeStats(&composites);
+
+    M_WriteText(4, y, "TEX");
+
+    M_snprintf(buf, sizeof(buf), "%i/%iK", composites.bytes / 1024, composite_cache_kb);
+    M_WriteText(36, y, buf);
+    M_snprintf(buf, sizeof(buf), "%iK", composites.peakbytes / 1024);
+    M_WriteText(100, y, buf);
+    M_snprintf(buf, sizeof(buf), "%u MISS %u REGEN", composites.misses, composites.regenerations);
+    M_WriteText(136, y, buf);
+}
+
+void M_ProfileDrawer(void)
+{
+    int y = 10;
+
+    if (show_profiler && history_len > 0)
+    {
+        y = DrawStages(y);
+    }
+
+    if (show_zonestats)
+    {
+        DrawZoneStats(y);
+    }
+}
+
+#endif
@@ -0,0 +1,79 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      Per-stage frame profiler.
+//
+
+
+#ifndef __M_PROFILE__
+#define __M_PROFILE__
+
+#include "doomfeatures.h"
+#include "doomtype.h"
+
+typedef enum
+{
+    prof_tics,          // TryRunTics
+    prof_ticker,        // P_Ticker
+    prof_bsp,           // R_RenderBSPNode
+    prof_planes,        // R_DrawPlanes
+    prof_masked,        // R_DrawMasked
+#ifdef FEATURE_TRANSPOSED_VIEW
+    prof_transpose,     // R_TransposeView
+#endif
+    prof_statusbar,     // ST_Drawer
+    prof_hud,           // HU_Drawer
+    prof_finishupdate,  // I_FinishUpdate (I_Stretch1x)
+    prof_frame,         // everything between D_Display calls
+
+    NUMPROFSTAGES
+} profstage_t;
+
+#ifdef FEATURE_PROFILER
+
+extern int show_profiler;
+extern int profiler_csv;
+extern int show_zonestats;
+
+void M_ProfileBegin(profstage_t stage);
+void M_ProfileEnd(profstage_t stage);
+
+// Called once per displayed frame, finishes off the previous frame
+void M_ProfileFrame(void);
+
+// Notes something that happened this frame (e.g. a detail change) in the
+// CSV and the overlay
+void M_ProfileEvent(const char *event);
+
+// Draws the min/avg/max overlay if show_profiler is set and the zone
+// usage overlay if show_zonestats is set
+void M_ProfileDrawer(void);
+
+#define PROFILE_BEGIN(stage) M_ProfileBegin(stage)
+#define PROFILE_END(stage) M_ProfileEnd(stage)
+#define PROFILE_EVENT(event) M_ProfileEvent(event)
+
+#else
+
+#define PROFILE_BEGIN(stage)
+#define PROFILE_END(stage)
+#define PROFILE_EVENT(event)
+
+#define M_ProfileFrame()
+#define M_ProfileDrawer()
+
+#endif
+
+#endif
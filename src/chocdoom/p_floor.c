@@ -358,7 +358,7 @@ EV_DoFloor
 	    floor->floordestheight = floor->sector->floorheight +
 		24 * FRACUNIT;
 
-		sector_t *frontsector = line->sidenum[0] == -1 ? 0 : sides[lines->sidenum[0]].sector;
+		sector_t *frontsector = LINE_FRONTSECTOR(line);
 	    sec->floorpic = frontsector->floorpic;
 	    sec->special = frontsector->special;
 	    break;
@@ -511,13 +511,13 @@ EV_BuildStairs
 		if ( !((sec->lines[i])->flags & ML_TWOSIDED) )
 		    continue;
 					
-		tsec = sec->lines[i]->sidenum[0] == -1 ? 0 : sides[sec->lines[i]->sidenum[0]].sector; // frontsector
+		tsec = LINE_FRONTSECTOR(sec->lines[i]);
 		newsecnum = tsec-sectors;
 		
 		if (secnum != newsecnum)
 		    continue;
 
-		tsec = sec->lines[i]->sidenum[1] == -1 ? 0 : sides[sec->lines[i]->sidenum[1]].sector; // backsector
+		tsec = LINE_BACKSECTOR(sec->lines[i]);
 		newsecnum = tsec - sectors;
 
 		if (tsec->floorpic != texture)
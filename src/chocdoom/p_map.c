@@ -225,7 +225,7 @@ boolean PIT_CheckLine (line_t* ld)
     // so two special lines that are only 8 pixels apart
     // could be crossed in either order.
 
-    sector_t *backsector = ld->sidenum[1] == -1 ? 0 : sides[ld->sidenum[1]].sector;
+    sector_t *backsector = LINE_BACKSECTOR(ld);
     
     if (!backsector)
 	return false;		// one sided line
@@ -636,7 +636,7 @@ void P_HitSlideLine (line_t* ld)
 	
     side = P_PointOnLineSide (slidemo->x, slidemo->y, ld);
 	
-    lineangle = R_PointToAngle2 (0,0, ld->v2->x - ld->v1->x, ld->v2->y - ld->v1->y);
+    lineangle = R_PointToAngle2 (0,0, LINE_DX(ld), LINE_DY(ld));
 
     if (side == 1)
 	lineangle += ANG180;
@@ -868,8 +868,8 @@ PTR_AimTraverse (intercept_t* in)
 	
 	dist = FixedMul (attackrange, in->frac);
 
-    sector_t *frontsector = li->sidenum[0] == -1 ? 0 : sides[li->sidenum[0]].sector;
-    sector_t *backsector = li->sidenum[1] == -1 ? 0 : sides[li->sidenum[1]].sector;
+    sector_t *frontsector = LINE_FRONTSECTOR(li);
+    sector_t *backsector = LINE_BACKSECTOR(li);
 
         if (backsector == NULL
          || frontsector->floorheight != backsector->floorheight)
@@ -953,8 +953,8 @@ boolean PTR_ShootTraverse (intercept_t* in)
 	if (li->special)
 	    P_ShootSpecialLine (shootthing, li);
 
-    sector_t *frontsector = li->sidenum[0] == -1 ? 0 : sides[li->sidenum[0]].sector;
-    sector_t *backsector = li->sidenum[1] == -1 ? 0 : sides[li->sidenum[1]].sector;
+    sector_t *frontsector = LINE_FRONTSECTOR(li);
+    sector_t *backsector = LINE_BACKSECTOR(li);
 
 	if ( !(li->flags & ML_TWOSIDED) )
 	    goto hitline;
@@ -68,8 +68,8 @@ P_PointOnLineSide
     fixed_t	left;
     fixed_t	right;
 
-    fixed_t ldx = line->v2->x - line->v1->x;
-    fixed_t ldy = line->v2->y - line->v1->y;
+    fixed_t ldx = LINE_DX(line);
+    fixed_t ldy = LINE_DY(line);
 	
     if (!ldx)
     {
@@ -112,8 +112,8 @@ P_BoxOnLineSide
     int		p1 = 0;
     int		p2 = 0;
 	
-    fixed_t ldx = ld->v2->x - ld->v1->x;
-    fixed_t ldy = ld->v2->y - ld->v1->y;
+    fixed_t ldx = LINE_DX(ld);
+    fixed_t ldy = LINE_DY(ld);
 
     switch (ld->slopetype)
     {
@@ -215,8 +215,8 @@ P_MakeDivline
 {
     dl->x = li->v1->x;
     dl->y = li->v1->y;
-    dl->dx = li->v2->x - li->v1->x;
-    dl->dy = li->v2->y - li->v1->y;
+    dl->dx = LINE_DX(li);
+    dl->dy = LINE_DY(li);
 }
 
 
@@ -310,8 +310,8 @@ void P_LineOpening (line_t* linedef)
 	return;
     }
 	 
-    front = linedef->sidenum[0] == -1 ? 0 : sides[linedef->sidenum[0]].sector;
-    back = linedef->sidenum[1] == -1 ? 0 : sides[linedef->sidenum[1]].sector;
+    front = LINE_FRONTSECTOR(linedef);
+    back = LINE_BACKSECTOR(linedef);
 	
     if (front->ceilingheight < back->ceilingheight)
 	opentop = front->ceilingheight;
@@ -595,7 +595,7 @@ PIT_AddLineIntercepts (line_t* ld)
 	return true;	// behind source
 	
     // try to early out the check
-    sector_t *backsector = ld->sidenum[1] == -1 ? 0 : sides[ld->sidenum[1]].sector;
+    sector_t *backsector = LINE_BACKSECTOR(ld);
     if (earlyout
 	&& frac < FRACUNIT
 	&& !backsector)
@@ -167,7 +167,7 @@ void P_XYMovement (mobj_t* mo)
 	    else if (mo->flags & MF_MISSILE)
 	    {
 		// explode a missile
-        sector_t *backsector = !ceilingline || ceilingline->sidenum[1] == -1 ? 0 : sides[ceilingline->sidenum[1]].sector;
+        sector_t *backsector = ceilingline ? LINE_BACKSECTOR(ceilingline) : 0;
 		if (backsector &&
 		    backsector->ceilingpic == skyflatnum)
 		{
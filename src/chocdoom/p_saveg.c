@@ -43,6 +43,62 @@ uint32_t save_stream_off;
 int savegamelength;
 boolean savegame_error;
 
+// The savegame is read/written a byte at a time, so go through a buffer
+// instead of doing a file operation for every byte. When reading this
+// holds the data starting at save_buffer_start, when writing it holds
+// the data that hasn't been written to the file yet.
+
+#define SAVE_BUFFER_SIZE 512
+
+static byte save_buffer[SAVE_BUFFER_SIZE];
+static uint32_t save_buffer_start;
+static uint32_t save_buffer_len;
+
+// How much of the buffer is used, 1 does a file operation per byte as
+// before there was a buffer (for the benchmark to compare against)
+
+int savegame_buffer_size = SAVE_BUFFER_SIZE;
+
+// Reset the stream state after opening a savegame
+
+void P_ResetSaveGameStream(void)
+{
+    save_stream_off = 0;
+    save_buffer_start = 0;
+    save_buffer_len = 0;
+
+    if (savegame_buffer_size < 1 || savegame_buffer_size > SAVE_BUFFER_SIZE)
+    {
+        savegame_buffer_size = SAVE_BUFFER_SIZE;
+    }
+
+    savegame_error = false;
+}
+
+// Write out anything left in the buffer
+
+void P_FlushSaveGameStream(void)
+{
+    if (save_buffer_len == 0)
+    {
+        return;
+    }
+
+    if (save_stream.write(save_buffer_start, save_buffer_len,
+                          (const char *)save_buffer) != save_buffer_len)
+    {
+        if (!savegame_error)
+        {
+            fprintf(stderr, "P_FlushSaveGameStream: Error while writing save game\n");
+
+            savegame_error = true;
+        }
+    }
+
+    save_buffer_start += save_buffer_len;
+    save_buffer_len = 0;
+}
+
 // Get the filename of a temporary file to write the savegame to.  After
 // the file has been successfully saved, it will be renamed to the 
 // real file.
@@ -84,10 +140,26 @@ char *P_SaveGameFile(int slot)
 static byte saveg_read8(void)
 {
     byte result;
-    unsigned long count;
 
-    if (save_stream.read(save_stream_off, 1, &result) != 1)
+    if (save_stream_off < save_buffer_start
+     || save_stream_off >= save_buffer_start + save_buffer_len)
     {
+        // read ahead
+        int32_t count = save_stream.read(save_stream_off, savegame_buffer_size,
+                                         (char *)save_buffer);
+
+        save_buffer_start = save_stream_off;
+        save_buffer_len = count > 0 ? count : 0;
+    }
+
+    if (save_stream_off < save_buffer_start + save_buffer_len)
+    {
+        result = save_buffer[save_stream_off - save_buffer_start];
+    }
+    else
+    {
+        result = 0;
+
         if (!savegame_error)
         {
             fprintf(stderr, "saveg_read8: Unexpected end of file while "
@@ -104,18 +176,13 @@ static byte saveg_read8(void)
 
 static void saveg_write8(byte value)
 {
-	unsigned long count;
-
-	if(!save_stream.write(save_stream_off, 1, &value))
+    if (save_buffer_len == (uint32_t) savegame_buffer_size)
     {
-        if (!savegame_error)
-        {
-            fprintf(stderr, "saveg_write8: Error while writing save game\n");
-
-            savegame_error = true;
-        }
+        P_FlushSaveGameStream();
     }
 
+    save_buffer[save_buffer_len++] = value;
+
     save_stream_off++;
 }
 
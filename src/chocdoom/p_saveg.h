@@ -34,6 +34,13 @@ char *P_TempSaveGameFile(void);
 
 char *P_SaveGameFile(int slot);
 
+// Savegame stream buffering
+
+void P_ResetSaveGameStream(void);
+void P_FlushSaveGameStream(void);
+
+extern int savegame_buffer_size;
+
 // Savegame file header read/write functions
 
 boolean P_ReadSaveGameHeader(void);
@@ -39,6 +39,7 @@
 #include "s_sound.h"
 
 #include "doomstat.h"
+#include "m_profile.h"
 
 
 void	P_SpawnMapThing (mapthing_t*	mthing);
@@ -147,6 +148,72 @@ void P_LoadVertexes (int lump)
     W_ReleaseLumpNum(lump);
 }
 
+// True if the current level's vertexes and segs are used from its PRECOMP
+// lump, so take no RAM
+boolean		levelprecompiled;
+
+//
+// P_PrecompiledFits
+// True if count elements of size bytes at ofs are aligned and lie
+// within a PRECOMP lump of length bytes.
+//
+static boolean P_PrecompiledFits (int ofs, int count, int size, int length)
+{
+    return ofs >= 0 && count >= 0
+        && (ofs & 3) == 0
+        && ofs <= length
+        && count <= (length - ofs) / size;
+}
+
+//
+// P_LoadPrecompiled
+// Points vertexes and segs straight at the level's PRECOMP lump, if
+// it has one that can be used in place. Returns false if the level has
+// to be loaded from the map lumps.
+//
+static boolean P_LoadPrecompiled (int lumpnum)
+{
+    int			lump = lumpnum + ML_PRECOMP;
+    byte*		data;
+    precomplevel_t*	header;
+
+    if (lump >= numlumps
+     || strncasecmp(lumpinfo[lump].ptr->name, "PRECOMP", 8)
+     || lumpinfo[lump].wad_file->mapped == NULL
+     || W_LumpLength(lump) < sizeof(precomplevel_t))
+    {
+	return false;
+    }
+
+    // Memory-mapped, so this doesn't copy anything
+    data = W_CacheLumpNum (lump, PU_STATIC);
+    header = (precomplevel_t *)data;
+
+    if (((uintptr_t)data & 3) != 0
+     || memcmp(header->magic, "PLVL", 4)
+     || header->version != PRECOMP_VERSION
+     || header->vertexsize != sizeof(vertex_t)
+     || header->segsize != sizeof(seg_t)
+     || header->numvertexes != W_LumpLength(lumpnum + ML_VERTEXES) / sizeof(mapvertex_t)
+     || header->numsegs != W_LumpLength(lumpnum + ML_SEGS) / sizeof(mapseg_t)
+     || !P_PrecompiledFits(header->vertexesofs, header->numvertexes,
+			   sizeof(vertex_t), W_LumpLength(lump))
+     || !P_PrecompiledFits(header->segsofs, header->numsegs,
+			   sizeof(seg_t), W_LumpLength(lump)))
+    {
+	printf ("P_LoadPrecompiled: PRECOMP for this level is out of date\n");
+	return false;
+    }
+
+    numvertexes = header->numvertexes;
+    vertexes = (vertex_t *)(data + header->vertexesofs);
+
+    numsegs = header->numsegs;
+    segs = (seg_t *)(data + header->segsofs);
+
+    return true;
+}
+
 //
 // GetSectorAtNullAddress
 //
@@ -189,16 +256,17 @@ void P_LoadSegs (int lump)
     li = segs;
     for (i=0 ; i<numsegs ; i++, li++, ml++)
     {
-	li->v1 = &vertexes[SHORT(ml->v1)];
-	li->v2 = &vertexes[SHORT(ml->v2)];
+	li->v1 = SHORT(ml->v1);
+	li->v2 = SHORT(ml->v2);
 
 	li->angle = (SHORT(ml->angle));//<<16;
 	li->offset = (SHORT(ml->offset));//<<16;
 	linedef = SHORT(ml->linedef);
 	ldef = &lines[linedef];
-	li->linedef = ldef;
+	li->linedef = linedef;
 	side = SHORT(ml->side);
-	li->sidedef = &sides[ldef->sidenum[side]];
+	li->sidedef = ldef->sidenum[side];
+	li->frontsector = sides[ldef->sidenum[side]].sector - sectors;
 
         if (ldef-> flags & ML_TWOSIDED)
         {
@@ -209,19 +277,22 @@ void P_LoadSegs (int lump)
             // the correct Vanilla behavior; however, it seems to work for
             // OTTAWAU.WAD, which is the one place I've seen this trick
             // used).
+            //
+            // The sector at the null address is kept after the last
+            // one, see P_LoadSectors.
 
             if (sidenum < 0 || sidenum >= numsides)
             {
-                li->backsector = GetSectorAtNullAddress();
+                li->backsector = numsectors;
             }
             else
             {
-                li->backsector = sides[sidenum].sector;
+                li->backsector = sides[sidenum].sector - sectors;
             }
         }
         else
         {
-	    li->backsector = 0;
+	    li->backsector = NO_INDEX;
         }
     }
 	
@@ -269,8 +340,12 @@ void P_LoadSectors (int lump)
     sector_t*		ss;
 	
     numsectors = W_LumpLength (lump) / sizeof(mapsector_t);
-    sectors = Z_Malloc (numsectors*sizeof(sector_t),PU_LEVEL,0);	
+
+    // One more for the "glass hack" back sector (see P_LoadSegs), segs
+    // refer to sectors by index
+    sectors = Z_Malloc ((numsectors + 1)*sizeof(sector_t),PU_LEVEL,0);	
     memset (sectors, 0, numsectors*sizeof(sector_t));
+    sectors[numsectors] = *GetSectorAtNullAddress();
     data = W_CacheLumpNum (lump,PU_STATIC);
 	
     ms = (mapsector_t *)data;
@@ -400,7 +475,7 @@ void P_LoadLineDefs (int lump)
     vertex_t*		v2;
 	
     numlines = W_LumpLength (lump) / sizeof(maplinedef_t);
-    lines = Z_Malloc (numlines*sizeof(line_t),PU_LEVEL,0);	
+    lines = Z_MallocHint (numlines*sizeof(line_t),PU_LEVEL,0,MEM_BULK);	
     memset (lines, 0, numlines*sizeof(line_t));
     data = W_CacheLumpNum (lump,PU_STATIC);
 	
@@ -453,6 +528,20 @@ void P_LoadLineDefs (int lump)
 	ld->sidenum[0] = SHORT(mld->sidenum[0]);
 	ld->sidenum[1] = SHORT(mld->sidenum[1]);
 
+#ifdef FEATURE_FAST_LINES
+	ld->dx = dx;
+	ld->dy = dy;
+
+	if (ld->sidenum[0] != -1)
+	    ld->frontsector = sides[ld->sidenum[0]].sector;
+	else
+	    ld->frontsector = 0;
+
+	if (ld->sidenum[1] != -1)
+	    ld->backsector = sides[ld->sidenum[1]].sector;
+	else
+	    ld->backsector = 0;
+#endif
     }
 
     W_ReleaseLumpNum(lump);
@@ -528,7 +617,7 @@ void P_LoadBlockMap (int lump)
     // Clear out mobj chains
 
     count = sizeof(*blocklinks) * bmapwidth * bmapheight;
-    blocklinks = Z_Malloc(count, PU_LEVEL, 0);
+    blocklinks = Z_MallocHint(count, PU_LEVEL, 0, MEM_BULK);
     memset(blocklinks, 0, count);
 }
 
@@ -556,7 +645,7 @@ void P_GroupLines (void)
     for (i=0 ; i<numsubsectors ; i++, ss++)
     {
 	seg = &segs[ss->firstline];
-	ss->sector = seg->sidedef->sector;
+	ss->sector = SEG_FRONTSECTOR(seg);
     }
 
     // count number of lines in each sector
@@ -566,8 +655,8 @@ void P_GroupLines (void)
     {
 	totallines++;
 
-    sector_t *frontsector = li->sidenum[0] == -1 ? 0 : sides[li->sidenum[0]].sector;
-    sector_t *backsector = li->sidenum[1] == -1 ? 0 : sides[li->sidenum[1]].sector;
+    sector_t *frontsector = LINE_FRONTSECTOR(li);
+    sector_t *backsector = LINE_BACKSECTOR(li);
 	frontsector->linecount++;
 
 	if (backsector && backsector != frontsector)
@@ -599,8 +688,8 @@ void P_GroupLines (void)
     { 
         li = &lines[i];
 
-        sector_t *frontsector = li->sidenum[0] == -1 ? 0 : sides[li->sidenum[0]].sector;
-        sector_t *backsector = li->sidenum[1] == -1 ? 0 : sides[li->sidenum[1]].sector;
+        sector_t *frontsector = LINE_FRONTSECTOR(li);
+        sector_t *backsector = LINE_BACKSECTOR(li);
 
         if (frontsector != NULL)
         {
@@ -733,7 +822,7 @@ static void P_LoadReject(int lumpnum)
     }
     else
     {
-        rejectmatrix = Z_Malloc(minlength, PU_LEVEL, &rejectmatrix);
+        rejectmatrix = Z_MallocHint(minlength, PU_LEVEL, &rejectmatrix, MEM_BULK);
         W_ReadLump(lumpnum, rejectmatrix);
 
         PadRejectArray(rejectmatrix + lumplen, minlength - lumplen);
@@ -769,8 +858,18 @@ P_SetupLevel
     // Make sure all sounds are stopped before Z_FreeTags.
     S_Start ();			
 
+#ifdef FEATURE_PROFILER
+    // the last level's slab usage, along with the zone overlay
+    if (show_zonestats)
+	Z_DumpSlabs ();
+#endif
+
     Z_FreeTags (PU_LEVEL, PU_PURGELEVEL-1);
 
+    // The last level's composites would be in the way of this one's data,
+    // R_PrecacheLevel builds the ones this level needs
+    R_FlushComposites ();
+
     // UNUSED W_Profile ();
     P_InitThinkers ();
 	   
@@ -795,16 +894,22 @@ P_SetupLevel
 	
     leveltime = 0;
 	
+    // the vertexes and segs don't need converting (or any RAM) if
+    // append_wads.py precompiled the level
+    levelprecompiled = P_LoadPrecompiled (lumpnum);
+
     // note: most of this ordering is important	
     P_LoadBlockMap (lumpnum+ML_BLOCKMAP);
-    P_LoadVertexes (lumpnum+ML_VERTEXES);
+    if (!levelprecompiled)
+	P_LoadVertexes (lumpnum+ML_VERTEXES);
     P_LoadSectors (lumpnum+ML_SECTORS);
     P_LoadSideDefs (lumpnum+ML_SIDEDEFS);
 
     P_LoadLineDefs (lumpnum+ML_LINEDEFS);
     P_LoadSubsectors (lumpnum+ML_SSECTORS);
     P_LoadNodes (lumpnum+ML_NODES);
-    P_LoadSegs (lumpnum+ML_SEGS);
+    if (!levelprecompiled)
+	P_LoadSegs (lumpnum+ML_SEGS);
 
     P_GroupLines ();
     P_LoadReject (lumpnum+ML_REJECT);
@@ -834,6 +939,8 @@ P_SetupLevel
     // build subsector connect matrix
     //	UNUSED P_ConnectSubsectors ();
 
+    R_SetupLevel ();
+
     // preload graphics
     if (precache)
 	R_PrecacheLevel ();
@@ -34,4 +34,6 @@ P_SetupLevel
 // Called by startup code.
 void P_Init (void);
 
+extern boolean	levelprecompiled;
+
 #endif
@@ -158,7 +158,7 @@ boolean P_CrossSubsector (int num)
 
     for ( ; count ; seg++, count--)
     {
-	line = seg->linedef;
+	line = SEG_LINEDEF(seg);
 
 	// allready checked other side?
 	if (line->validcount == validcount)
@@ -177,8 +177,8 @@ boolean P_CrossSubsector (int num)
 	
 	divl.x = v1->x;
 	divl.y = v1->y;
-	divl.dx = v2->x - v1->x;
-	divl.dy = v2->y - v1->y;
+	divl.dx = LINE_DX(line);
+	divl.dy = LINE_DY(line);
 	s1 = P_DivlineSide (strace.x, strace.y, &divl);
 	s2 = P_DivlineSide (t2x, t2y, &divl);
 
@@ -200,8 +200,8 @@ boolean P_CrossSubsector (int num)
 	    return false;
 	
 	// crosses a two sided line
-	front = seg->sidedef->sector;
-	back = seg->backsector;
+	front = SEG_FRONTSECTOR(seg);
+	back = SEG_BACKSECTOR(seg);
 
 	// no wall to block sight with?
 	if (front->floorheight == back->floorheight
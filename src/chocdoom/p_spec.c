@@ -254,8 +254,8 @@ getNextSector
     if (!(line->flags & ML_TWOSIDED))
 	return NULL;
 
-    sector_t *frontsector = line->sidenum[0] == -1 ? 0 : sides[line->sidenum[0]].sector;
-    sector_t *backsector = line->sidenum[1] == -1 ? 0 : sides[line->sidenum[1]].sector;
+    sector_t *frontsector = LINE_FRONTSECTOR(line);
+    sector_t *backsector = LINE_BACKSECTOR(line);
 
     if (frontsector == sec)
 	return backsector;
@@ -1301,7 +1301,7 @@ int EV_DoDonut(line_t*	line)
 
 	for (i = 0; i < s2->linecount; i++)
 	{
-	    s3 = s2->lines[i]->sidenum[1] == -1 ? 0 : sides[s2->lines[i]->sidenum[1]].sector; // backsector
+	    s3 = LINE_BACKSECTOR(s2->lines[i]);
 
 	    if (s3 == s1)
 		continue;
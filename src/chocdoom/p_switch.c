@@ -176,7 +176,7 @@ P_StartButton
 	    buttonlist[i].btexture = texture;
 	    buttonlist[i].btimer = time;
 
-		sector_t *frontsector = line->sidenum[0] == -1 ? 0 : sides[line->sidenum[0]].sector;
+		sector_t *frontsector = LINE_FRONTSECTOR(line);
 	    buttonlist[i].soundorg = &frontsector->soundorg;
 	    return;
 	}
@@ -0,0 +1,351 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      Per-tic simulation checksums.
+//      After each tic of a level, each part of the play simulation is
+//      hashed separately, so that when a demo stops matching the tic
+//      and the part that went wrong first can be reported. The sums
+//      are kept in a sidecar file next to the demo (NUMTICSUMS
+//      unsigned ints per tic).
+//
+
+#include <stdio.h>
+#include <string.h>
+
+#include "doomstat.h"
+#include "m_misc.h"
+#include "p_local.h"
+#include "p_ticsum.h"
+#include "r_state.h"
+
+#ifdef FEATURE_TIC_CHECKSUM
+
+extern int prndindex;
+
+// Tics to buffer before writing to/after reading from the file
+
+#define TICSUM_CHUNK 64
+
+static const char *ticsum_names[NUMTICSUMS] =
+{
+    "MOBJS",
+    "PLAYERS",
+    "SECTORS",
+    "RANDOM",
+};
+
+static enum
+{
+    ticsum_off,
+    ticsum_recording,
+    ticsum_checking,
+} ticsum_mode = ticsum_off;
+
+static blit::File ticsum_file;
+static uint32_t ticsum_offset;
+static uint32_t ticsum_length;
+
+static unsigned int ticsum_buffer[TICSUM_CHUNK][NUMTICSUMS];
+static int ticsum_buffer_len;
+static int ticsum_buffer_pos;
+
+static int ticsum_tic;
+static boolean ticsum_diverged;
+
+static void Mix(unsigned int *sum, int value)
+{
+    *sum = (*sum ^ (unsigned int) value) * 16777619u;
+}
+
+static void SumMobjs(unsigned int *sum)
+{
+    thinker_t *th;
+    mobj_t *mo;
+
+    for (th = thinkercap.next; th != &thinkercap; th = th->next)
+    {
+        if (th->function.acp1 != (actionf_p1) P_MobjThinker)
+        {
+            continue;
+        }
+
+        mo = (mobj_t *) th;
+
+        Mix(sum, mo->type);
+        Mix(sum, mo->x);
+        Mix(sum, mo->y);
+        Mix(sum, mo->z);
+        Mix(sum, mo->momx);
+        Mix(sum, mo->momy);
+        Mix(sum, mo->momz);
+        Mix(sum, mo->angle);
+        Mix(sum, mo->state - states);
+        Mix(sum, mo->tics);
+        Mix(sum, mo->flags);
+        Mix(sum, mo->health);
+        Mix(sum, mo->movedir);
+        Mix(sum, mo->movecount);
+        Mix(sum, mo->reactiontime);
+    }
+}
+
+static void SumPlayers(unsigned int *sum)
+{
+    player_t *player;
+    int i, j;
+
+    for (i = 0; i < MAXPLAYERS; ++i)
+    {
+        if (!playeringame[i])
+        {
+            continue;
+        }
+
+        player = &players[i];
+
+        Mix(sum, player->playerstate);
+        Mix(sum, player->viewz);
+        Mix(sum, player->health);
+        Mix(sum, player->armorpoints);
+        Mix(sum, player->armortype);
+        Mix(sum, player->readyweapon);
+        Mix(sum, player->pendingweapon);
+        Mix(sum, player->killcount);
+        Mix(sum, player->itemcount);
+        Mix(sum, player->secretcount);
+
+        for (j = 0; j < NUMAMMO; ++j)
+        {
+            Mix(sum, player->ammo[j]);
+        }
+
+        for (j = 0; j < NUMPOWERS; ++j)
+        {
+            Mix(sum, player->powers[j]);
+        }
+
+        for (j = 0; j < NUMPSPRITES; ++j)
+        {
+            Mix(sum, player->psprites[j].state
+                   ? player->psprites[j].state - states : -1);
+            Mix(sum, player->psprites[j].tics);
+        }
+    }
+}
+
+static void SumSectors(unsigned int *sum)
+{
+    sector_t *sector;
+    int i;
+
+    for (i = 0, sector = sectors; i < numsectors; ++i, ++sector)
+    {
+        Mix(sum, sector->floorheight);
+        Mix(sum, sector->ceilingheight);
+        Mix(sum, sector->lightlevel);
+        Mix(sum, sector->special);
+    }
+}
+
+static void SumTic(unsigned int *sums)
+{
+    int i;
+
+    for (i = 0; i < NUMTICSUMS; ++i)
+    {
+        sums[i] = 2166136261u;
+    }
+
+    SumMobjs(&sums[ticsum_mobjs]);
+    SumPlayers(&sums[ticsum_players]);
+    SumSectors(&sums[ticsum_sectors]);
+
+    // rndindex is seeded from the clock and only used outside of the
+    // play simulation, so only prndindex has to match
+    Mix(&sums[ticsum_random], prndindex);
+}
+
+static void FlushSums(void)
+{
+    ticsum_file.write(ticsum_offset, ticsum_buffer_len * sizeof(ticsum_buffer[0]),
+                      (const char *) ticsum_buffer);
+    ticsum_offset += ticsum_buffer_len * sizeof(ticsum_buffer[0]);
+    ticsum_buffer_len = 0;
+}
+
+// Returns false if there are no more recorded tics
+static boolean ReadSums(void)
+{
+    uint32_t len = ticsum_length - ticsum_offset;
+
+    if (len > sizeof(ticsum_buffer))
+    {
+        len = sizeof(ticsum_buffer);
+    }
+
+    ticsum_buffer_len = len / sizeof(ticsum_buffer[0]);
+    ticsum_buffer_pos = 0;
+
+    if (ticsum_buffer_len == 0)
+    {
+        return false;
+    }
+
+    ticsum_file.read(ticsum_offset, ticsum_buffer_len * sizeof(ticsum_buffer[0]),
+                     (char *) ticsum_buffer);
+    ticsum_offset += ticsum_buffer_len * sizeof(ticsum_buffer[0]);
+
+    return true;
+}
+
+static void ReportDivergence(unsigned int *sums, unsigned int *expected)
+{
+    static char message[80];
+    int first;
+    int i;
+
+    for (first = 0; first < NUMTICSUMS - 1; ++first)
+    {
+        if (sums[first] != expected[first])
+        {
+            break;
+        }
+    }
+
+    printf("P_TicSumTic: tic %i diverged in %s (%08x should be %08x)\n",
+           ticsum_tic, ticsum_names[first], sums[first], expected[first]);
+
+    for (i = first + 1; i < NUMTICSUMS; ++i)
+    {
+        if (sums[i] != expected[i])
+        {
+            printf("P_TicSumTic: %s also diverged\n", ticsum_names[i]);
+        }
+    }
+
+    M_snprintf(message, sizeof(message), "desync at tic %i (%s)",
+               ticsum_tic, ticsum_names[first]);
+    players[consoleplayer].message = message;
+
+    ticsum_diverged = true;
+}
+
+void P_TicSumRecord(char *filename)
+{
+    P_TicSumEnd();
+
+    if (!ticsum_file.open(filename, blit::OpenMode::write))
+    {
+        printf("P_TicSumRecord: failed to open %s\n", filename);
+        return;
+    }
+
+    ticsum_mode = ticsum_recording;
+    ticsum_offset = 0;
+    ticsum_buffer_len = 0;
+    ticsum_tic = 0;
+}
+
+void P_TicSumPlayback(char *filename)
+{
+    P_TicSumEnd();
+
+    ticsum_diverged = false;
+
+    if (!M_FileExists(filename) || !ticsum_file.open(filename))
+    {
+        return;
+    }
+
+    printf("P_TicSumPlayback: checking against %s\n", filename);
+
+    ticsum_mode = ticsum_checking;
+    ticsum_offset = 0;
+    ticsum_length = ticsum_file.get_length();
+    ticsum_buffer_len = 0;
+    ticsum_buffer_pos = 0;
+    ticsum_tic = 0;
+}
+
+void P_TicSumTic(void)
+{
+    unsigned int sums[NUMTICSUMS];
+
+    if (ticsum_mode == ticsum_off)
+    {
+        return;
+    }
+
+    SumTic(sums);
+
+    if (ticsum_mode == ticsum_recording)
+    {
+        memcpy(ticsum_buffer[ticsum_buffer_len], sums, sizeof(sums));
+
+        if (++ticsum_buffer_len == TICSUM_CHUNK)
+        {
+            FlushSums();
+        }
+    }
+    else
+    {
+        if (ticsum_buffer_pos == ticsum_buffer_len && !ReadSums())
+        {
+            printf("P_TicSumTic: no checksums past tic %i\n", ticsum_tic);
+            P_TicSumEnd();
+            return;
+        }
+
+        if (memcmp(sums, ticsum_buffer[ticsum_buffer_pos], sizeof(sums)))
+        {
+            // Only the first tic is of any use, everything after it
+            // will be different too
+            ReportDivergence(sums, ticsum_buffer[ticsum_buffer_pos]);
+            P_TicSumEnd();
+            return;
+        }
+
+        ticsum_buffer_pos++;
+    }
+
+    ticsum_tic++;
+}
+
+void P_TicSumEnd(void)
+{
+    if (ticsum_mode == ticsum_recording && ticsum_buffer_len > 0)
+    {
+        FlushSums();
+    }
+
+    if (ticsum_mode == ticsum_checking && !ticsum_diverged)
+    {
+        printf("P_TicSumEnd: %i tics matched\n", ticsum_tic);
+    }
+
+    if (ticsum_file.is_open())
+    {
+        ticsum_file.close();
+    }
+
+    ticsum_mode = ticsum_off;
+}
+
+boolean P_TicSumDiverged(void)
+{
+    return ticsum_diverged;
+}
+
+#endif
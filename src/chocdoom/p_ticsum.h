@@ -0,0 +1,64 @@
+//
+// Copyright(C) 1993-1996 Id Software, Inc.
+// Copyright(C) 2005-2014 Simon Howard
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// DESCRIPTION:
+//      Per-tic simulation checksums, written alongside a demo while
+//      recording and checked against while playing it back.
+//
+
+
+#ifndef __P_TICSUM__
+#define __P_TICSUM__
+
+#include "doomfeatures.h"
+#include "doomtype.h"
+
+typedef enum
+{
+    ticsum_mobjs,       // positions, momentum, states and health
+    ticsum_players,     // player state, inventory and weapon sprites
+    ticsum_sectors,     // floor/ceiling heights and lighting
+    ticsum_random,      // prndindex
+
+    NUMTICSUMS
+} ticsum_t;
+
+#ifdef FEATURE_TIC_CHECKSUM
+
+// Start writing the checksums for each tic to filename
+void P_TicSumRecord(char *filename);
+
+// Start checking each tic against filename, if it exists
+void P_TicSumPlayback(char *filename);
+
+// Called after P_Ticker, records or checks the tic that has just run
+void P_TicSumTic(void);
+
+// Finishes off recording or checking
+void P_TicSumEnd(void);
+
+// true if a tic has not matched since P_TicSumPlayback
+boolean P_TicSumDiverged(void);
+
+#else
+
+#define P_TicSumRecord(filename)
+#define P_TicSumPlayback(filename)
+#define P_TicSumTic()
+#define P_TicSumEnd()
+#define P_TicSumDiverged() false
+
+#endif
+
+#endif
@@ -43,9 +43,11 @@ line_t*		linedef;
 sector_t*	frontsector;
 sector_t*	backsector;
 
-drawseg_t	drawsegs[MAXDRAWSEGS];
+drawseg_t*	drawsegs;
 drawseg_t*	ds_p;
 
+rpool_t		drawsegpool = {"drawsegs", sizeof(drawseg_t), MEM_FAST};
+
 
 void
 R_StoreWallRange
@@ -60,6 +62,8 @@ R_StoreWallRange
 //
 void R_ClearDrawSegs (void)
 {
+    R_CheckPool (&drawsegpool, (void **)&drawsegs);
+
     ds_p = drawsegs;
 }
 
@@ -238,8 +242,8 @@ R_ClipPassWallSegment
 void R_ClearClipSegs (void)
 {
     solidsegs[0].first = -0x7fffffff;
-    solidsegs[0].last = -1;
-    solidsegs[1].first = viewwidth;
+    solidsegs[0].last = stripstart - 1;
+    solidsegs[1].first = stripend;
     solidsegs[1].last = 0x7fffffff;
     newend = solidsegs+2;
 }
@@ -261,8 +265,8 @@ void R_AddLine (seg_t*	line)
     curline = line;
 
     // OPTIMIZE: quickly reject orthogonal back sides.
-    angle1 = R_PointToAngle (line->v1->x, line->v1->y);
-    angle2 = R_PointToAngle (line->v2->x, line->v2->y);
+    angle1 = R_PointToAngle (SEG_V1(line)->x, SEG_V1(line)->y);
+    angle2 = R_PointToAngle (SEG_V2(line)->x, SEG_V2(line)->y);
     
     // Clip to view edges.
     // OPTIMIZE: make constant out of 2*clipangle (FIELDOFVIEW).
@@ -310,7 +314,7 @@ void R_AddLine (seg_t*	line)
     if (x1 == x2)
 	return;				
 	
-    backsector = line->backsector;
+    backsector = SEG_BACKSECTOR(line);
 
     // Single sided line?
     if (!backsector)
@@ -334,7 +338,7 @@ void R_AddLine (seg_t*	line)
     if (backsector->ceilingpic == frontsector->ceilingpic
 	&& backsector->floorpic == frontsector->floorpic
 	&& backsector->lightlevel == frontsector->lightlevel
-	&& curline->sidedef->midtexture == 0)
+	&& SEG_SIDEDEF(curline)->midtexture == 0)
     {
 	return;
     }
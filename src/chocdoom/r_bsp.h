@@ -39,8 +39,9 @@ extern boolean		markceiling;
 
 extern boolean		skymap;
 
-extern drawseg_t	drawsegs[MAXDRAWSEGS];
+extern drawseg_t*	drawsegs;
 extern drawseg_t*	ds_p;
+extern rpool_t		drawsegpool;
 
 extern lighttable_t**	hscalelight;
 extern lighttable_t**	vscalelight;
@@ -19,16 +19,20 @@
 
 #include <stdio.h>
 
+#include "config.h"
 #include "deh_main.h"
 #include "i_swap.h"
 #include "i_system.h"
+#include "i_timer.h"
 #include "z_zone.h"
 
 
+#include "w_checksum.h"
 #include "w_wad.h"
 
 #include "doomdef.h"
 #include "m_misc.h"
+#include "m_profile.h"
 #include "r_local.h"
 #include "p_local.h"
 
@@ -151,10 +155,37 @@ short**			texturecolumnlump;
 unsigned short**	texturecolumnofs;
 byte**			texturecomposite;
 
+//
+// Composite textures are kept PU_STATIC until they add up to more than
+// composite_cache_kb, then the ones drawn the longest ago are freed to
+// make room. When a zone has no room for some other allocation, the
+// zone's purge hook frees them oldest first too, and they are all freed
+// at the start of each level. With composite_cache_kb 0 they are
+// PU_CACHE instead, and the zone purges them whenever it needs the memory.
+//
+int			composite_cache_kb = 128;
+
+// If non-zero, only the columns of a composite that are drawn get built.
+int			composite_columns = 0;
+
+// framecount each composite was last drawn in
+static int*		compositeframe;
+
+// composite was built before, so missing it again is a regeneration
+static byte*		compositebuilt;
+
+// composite being drawn into, which the purge hook must leave alone
+static int		compositebusy = -1;
+
+static compositestats_t	compositestats;
+
 // for global animation
 int*		flattranslation;
 int*		texturetranslation;
 
+// copies of the flats being drawn in fast RAM, purgable
+static byte**	flatcache;
+
 // needed for pre rendering
 fixed_t*	spritewidth;	
 fixed_t*	spriteoffset;
@@ -163,6 +194,50 @@ fixed_t*	spritetopoffset;
 lighttable_t	*colormaps;
 
 
+//
+// Tables baked by append_wads.py for a set of WADs, keyed by the
+// W_Checksum of the WADs that were loaded. When the loaded set matches
+// one of them, the texture column lookups and sprite sizes point into
+// the mapped file instead of being generated into zone memory.
+//
+#define BAKED_TABLES_FILE FILES_DIR "/rdata.tbl"
+
+typedef struct
+{
+    // Should be "RTBL"
+    char		identification[4];
+    int			numentries;
+    // followed by bakedtablesentry_t entries[numentries]
+} PACKEDATTR bakedtablesheader_t;
+
+typedef struct
+{
+    sha1_digest_t	sha1;
+    int			offset;		// of the bakedtables_t
+} PACKEDATTR bakedtablesentry_t;
+
+// Offsets are from the start of the file, and aligned
+typedef struct
+{
+    int			numtextures;
+    int			totalwidth;
+    int			numspritelumps;
+    int			compositesizeofs;	// int[numtextures]
+    int			widthmaskofs;		// int[numtextures]
+    int			heightofs;		// fixed_t[numtextures]
+    int			spritewidthofs;		// fixed_t[numspritelumps]
+    int			spriteoffsetofs;	// fixed_t[numspritelumps]
+    int			spritetopoffsetofs;	// fixed_t[numspritelumps]
+    int			columnlumpofs;		// short[totalwidth]
+    int			columnofsofs;		// unsigned short[totalwidth]
+} PACKEDATTR bakedtables_t;
+
+static byte*		bakedfile;
+static bakedtables_t*	baked;
+
+#define BAKED(ofs) ((void *)(bakedfile + (ofs)))
+
+
 //
 // MAPTEXTURE_T CACHING
 // When a texture is first needed,
@@ -218,12 +293,11 @@ R_DrawColumnInCache
 
 
 //
-// R_GenerateComposite
-// Using the texture definition,
-//  the composite texture is created from the patches,
-//  and each column is cached.
+// R_CompositeColumns
+// Draws the columns of the texture from start up to stop that have
+// more than one patch into its composite.
 //
-void R_GenerateComposite (int texnum)
+static void R_CompositeColumns (int texnum, int start, int stop)
 {
     byte*		block;
     texture_t*		texture;
@@ -238,32 +312,34 @@ void R_GenerateComposite (int texnum)
     unsigned short*	colofs;
 	
     texture = textures[texnum];
-
-    block = Z_Malloc (texturecompositesize[texnum],
-		      PU_STATIC, 
-		      &texturecomposite[texnum]);	
+    block = texturecomposite[texnum];
 
     collump = texturecolumnlump[texnum];
     colofs = texturecolumnofs[texnum];
+
+    // Caching the patches could need memory
+    compositebusy = texnum;
     
     // Composite the columns together.
-    patch = texture->patches;
-		
     for (i=0 , patch = texture->patches;
 	 i<texture->patchcount;
 	 i++, patch++)
     {
-	realpatch = W_CacheLumpNum (patch->patch, PU_CACHE);
 	x1 = patch->originx;
+
+	if (x1 >= stop)
+	    continue;
+
+	realpatch = W_CacheLumpNum (patch->patch, PU_CACHE);
 	x2 = x1 + SHORT(realpatch->width);
 
-	if (x1<0)
-	    x = 0;
+	if (x1<start)
+	    x = start;
 	else
 	    x = x1;
 	
-	if (x2 > texture->width)
-	    x2 = texture->width;
+	if (x2 > stop)
+	    x2 = stop;
 
 	for ( ; x<x2 ; x++)
 	{
@@ -281,9 +357,238 @@ void R_GenerateComposite (int texnum)
 						
     }
 
+    compositebusy = -1;
+}
+
+
+//
+// R_CompositeBlockSize
+// The composite is followed by a bit for each column, set once the
+// column has been built.
+//
+static int R_CompositeBlockSize (int texnum)
+{
+    return texturecompositesize[texnum] + ((textures[texnum]->width + 7) >> 3);
+}
+
+
+//
+// R_FreeComposite
+//
+static void R_FreeComposite (int texnum)
+{
+    compositestats.bytes -= R_CompositeBlockSize(texnum);
+    compositestats.evictions++;
+
+    // clears texturecomposite[texnum]
+    Z_Free (texturecomposite[texnum]);
+}
+
+
+//
+// R_FreeOldestComposite
+// Frees the composite that was drawn the longest ago. Unless thisframe
+// is set, not one drawn in this frame: going over budget for a frame is
+// better than building the same composites over and over while drawing
+// it. Never the one being drawn into.
+// Returns false if there was nothing to free.
+//
+static boolean R_FreeOldestComposite (boolean thisframe)
+{
+    int		i;
+    int		oldest = -1;
+
+    for (i=0 ; i<numtextures ; i++)
+    {
+	if (texturecomposite[i] == NULL || i == compositebusy
+	 || (!thisframe && compositeframe[i] == framecount))
+	    continue;
+
+	if (oldest < 0 || compositeframe[i] < compositeframe[oldest])
+	    oldest = i;
+    }
+
+    if (oldest < 0)
+	return false;
+
+    R_FreeComposite (oldest);
+    return true;
+}
+
+
+//
+// R_PurgeComposite
+// The zone's purge hook, frees the composite that was drawn the longest
+// ago. Ones drawn in this frame go only when nothing else is left, as
+// the alternative is the allocation failing.
+//
+static boolean R_PurgeComposite (void)
+{
+    if (composite_cache_kb <= 0)
+	return false;
+
+    return R_FreeOldestComposite (false) || R_FreeOldestComposite (true);
+}
+
+
+//
+// R_FlushComposites
+// Frees all of the composites, so that the level's data doesn't have
+// to fit around the last level's.
+//
+void R_FlushComposites (void)
+{
+    int		i;
+
+    for (i=0 ; i<numtextures ; i++)
+    {
+	if (texturecomposite[i] != NULL)
+	    Z_Free (texturecomposite[i]);
+    }
+
+    compositestats.bytes = 0;
+}
+
+
+//
+// R_AllocComposite
+//
+static void R_AllocComposite (int texnum)
+{
+    int		size;
+
+    size = R_CompositeBlockSize(texnum);
+
+    compositebuilt[texnum] = 1;
+
+    if (composite_cache_kb <= 0)
+    {
+	Z_MallocHint (size, PU_STATIC, &texturecomposite[texnum], MEM_FAST);
+	return;
+    }
+
+    while (compositestats.bytes + size > composite_cache_kb * 1024)
+    {
+	if (!R_FreeOldestComposite(false))
+	    break;
+    }
+
+    // R_PurgeComposite makes room if all the zones are short
+    Z_MallocHint (size, PU_STATIC, &texturecomposite[texnum], MEM_FAST);
+
+    compositestats.bytes += size;
+
+    if (compositestats.bytes > compositestats.peakbytes)
+	compositestats.peakbytes = compositestats.bytes;
+}
+
+
+//
+// R_GenerateComposite
+// Using the texture definition,
+//  the composite texture is created from the patches,
+//  and each column is cached.
+// With composite_columns set, the columns are left to
+//  R_GenerateCompositeColumn.
+//
+void R_GenerateComposite (int texnum)
+{
+    texture_t*		texture;
+    byte*		built;
+
+    texture = textures[texnum];
+
+    R_AllocComposite (texnum);
+
+    built = texturecomposite[texnum] + texturecompositesize[texnum];
+
+    if (composite_columns)
+    {
+	memset (built, 0, (texture->width + 7) >> 3);
+    }
+    else
+    {
+	R_CompositeColumns (texnum, 0, texture->width);
+	memset (built, 0xff, (texture->width + 7) >> 3);
+    }
+
     // Now that the texture has been built in column cache,
-    //  it is purgable from zone memory.
-    Z_ChangeTag (block, PU_CACHE);
+    //  it is purgable from zone memory (unless the composite
+    //  cache is looking after it).
+    if (composite_cache_kb <= 0)
+	Z_ChangeTag (texturecomposite[texnum], PU_CACHE);
+}
+
+
+//
+// R_GenerateCompositeColumn
+//
+static void R_GenerateCompositeColumn (int texnum, int col)
+{
+    byte*		built;
+
+    if (composite_cache_kb <= 0)
+	Z_ChangeTag (texturecomposite[texnum], PU_STATIC);
+
+    R_CompositeColumns (texnum, col, col + 1);
+
+    built = texturecomposite[texnum] + texturecompositesize[texnum];
+    built[col >> 3] |= 1 << (col & 7);
+
+    if (composite_cache_kb <= 0)
+	Z_ChangeTag (texturecomposite[texnum], PU_CACHE);
+}
+
+
+//
+// R_PrecacheComposite
+// Builds all of the composite, whether or not composite_columns is set.
+//
+static void R_PrecacheComposite (int texnum)
+{
+    byte*		built;
+
+    if (!texturecomposite[texnum])
+	R_GenerateComposite (texnum);
+
+    compositeframe[texnum] = framecount;
+
+    if (composite_columns)
+    {
+	if (composite_cache_kb <= 0)
+	    Z_ChangeTag (texturecomposite[texnum], PU_STATIC);
+
+	R_CompositeColumns (texnum, 0, textures[texnum]->width);
+
+	built = texturecomposite[texnum] + texturecompositesize[texnum];
+	memset (built, 0xff, (textures[texnum]->width + 7) >> 3);
+
+	if (composite_cache_kb <= 0)
+	    Z_ChangeTag (texturecomposite[texnum], PU_CACHE);
+    }
+}
+
+
+//
+// R_GetCompositeStats
+//
+void R_GetCompositeStats (compositestats_t *stats)
+{
+    *stats = compositestats;
+}
+
+
+//
+// R_ResetCompositeStats
+// Clears the counters, but not what the cache is holding.
+//
+void R_ResetCompositeStats (void)
+{
+    compositestats.hits = 0;
+    compositestats.misses = 0;
+    compositestats.regenerations = 0;
+    compositestats.evictions = 0;
+    compositestats.peakbytes = compositestats.bytes;
 }
 
 
@@ -394,8 +699,28 @@ R_GetColumn
     if (lump > 0)
 	return (byte *)W_CacheLumpNum(lump,PU_CACHE)+ofs;
 
+    // hits and misses are counted for the first use in a frame
+    if (compositeframe[tex] != framecount)
+    {
+	compositeframe[tex] = framecount;
+
+	if (texturecomposite[tex])
+	    compositestats.hits++;
+    }
+
     if (!texturecomposite[tex])
+    {
+	compositestats.misses++;
+
+	if (compositebuilt[tex])
+	    compositestats.regenerations++;
+
 	R_GenerateComposite (tex);
+    }
+
+    if (!(texturecomposite[tex][texturecompositesize[tex] + (col >> 3)]
+	  & (1 << (col & 7))))
+	R_GenerateCompositeColumn (tex, col);
 
     return texturecomposite[tex] + ofs;
 }
@@ -518,14 +843,29 @@ void R_InitTextures (void)
 	maxoff2 = 0;
     }
     numtextures = numtextures1 + numtextures2;
+
 	
     textures = Z_Malloc (numtextures * sizeof(*textures), PU_STATIC, 0);
     texturecolumnlump = Z_Malloc (numtextures * sizeof(*texturecolumnlump), PU_STATIC, 0);
     texturecolumnofs = Z_Malloc (numtextures * sizeof(*texturecolumnofs), PU_STATIC, 0);
     texturecomposite = Z_Malloc (numtextures * sizeof(*texturecomposite), PU_STATIC, 0);
-    texturecompositesize = Z_Malloc (numtextures * sizeof(*texturecompositesize), PU_STATIC, 0);
-    texturewidthmask = Z_Malloc (numtextures * sizeof(*texturewidthmask), PU_STATIC, 0);
-    textureheight = Z_Malloc (numtextures * sizeof(*textureheight), PU_STATIC, 0);
+    compositeframe = Z_Malloc (numtextures * sizeof(*compositeframe), PU_STATIC, 0);
+    memset (compositeframe, 0xff, numtextures * sizeof(*compositeframe));
+    compositebuilt = Z_Malloc (numtextures, PU_STATIC, 0);
+    memset (compositebuilt, 0, numtextures);
+
+    if (baked != NULL)
+    {
+        texturecompositesize = BAKED(baked->compositesizeofs);
+        texturewidthmask = BAKED(baked->widthmaskofs);
+        textureheight = BAKED(baked->heightofs);
+    }
+    else
+    {
+        texturecompositesize = Z_Malloc (numtextures * sizeof(*texturecompositesize), PU_STATIC, 0);
+        texturewidthmask = Z_Malloc (numtextures * sizeof(*texturewidthmask), PU_STATIC, 0);
+        textureheight = Z_Malloc (numtextures * sizeof(*textureheight), PU_STATIC, 0);
+    }
 
     totalwidth = 0;
     
@@ -592,15 +932,24 @@ void R_InitTextures (void)
 			 texture->name);
 	    }
 	}		
-	texturecolumnlump[i] = Z_Malloc (texture->width*sizeof(**texturecolumnlump), PU_STATIC,0);
-	texturecolumnofs[i] = Z_Malloc (texture->width*sizeof(**texturecolumnofs), PU_STATIC,0);
+	if (baked != NULL)
+	{
+	    // the columns of all the textures, one after the other
+	    texturecolumnlump[i] = (short *) BAKED(baked->columnlumpofs) + totalwidth;
+	    texturecolumnofs[i] = (unsigned short *) BAKED(baked->columnofsofs) + totalwidth;
+	}
+	else
+	{
+	    texturecolumnlump[i] = Z_Malloc (texture->width*sizeof(**texturecolumnlump), PU_STATIC,0);
+	    texturecolumnofs[i] = Z_Malloc (texture->width*sizeof(**texturecolumnofs), PU_STATIC,0);
 
-	j = 1;
-	while (j*2 <= texture->width)
-	    j<<=1;
+	    j = 1;
+	    while (j*2 <= texture->width)
+		j<<=1;
 
-	texturewidthmask[i] = j-1;
-	textureheight[i] = texture->height<<FRACBITS;
+	    texturewidthmask[i] = j-1;
+	    textureheight[i] = texture->height<<FRACBITS;
+	}
 		
 	totalwidth += texture->width;
     }
@@ -613,8 +962,19 @@ void R_InitTextures (void)
     
     // Precalculate whatever possible.	
 
-    for (i=0 ; i<numtextures ; i++)
-	R_GenerateLookup (i);
+    if (baked != NULL)
+    {
+        // Composited textures not created yet.
+        memset (texturecomposite, 0, numtextures * sizeof(*texturecomposite));
+    }
+    else
+    {
+        for (i=0 ; i<numtextures ; i++)
+            R_GenerateLookup (i);
+    }
+
+    // texturecomposite is all set now
+    Z_SetPurgeHook (R_PurgeComposite);
     
     // Create translation table for global animation.
     texturetranslation = Z_Malloc ((numtextures+1)*sizeof(*texturetranslation), PU_STATIC, 0);
@@ -643,6 +1003,28 @@ void R_InitFlats (void)
     
     for (i=0 ; i<numflats ; i++)
 	flattranslation[i] = i;
+
+    flatcache = Z_Malloc (numflats*sizeof(*flatcache), PU_STATIC, 0);
+    memset (flatcache, 0, numflats*sizeof(*flatcache));
+}
+
+
+//
+// R_GetFlat
+// Returns the flat data, copying it out of the WAD the first time it is
+// drawn. The copy is PU_CACHE so it gets dropped if memory runs short.
+//
+byte *R_GetFlat (int flat)
+{
+    int lump = firstflat + flat;
+
+    if (!flatcache[flat])
+    {
+	Z_MallocHint (W_LumpLength(lump), PU_CACHE, &flatcache[flat], MEM_FAST);
+	W_ReadLump (lump, flatcache[flat]);
+    }
+
+    return flatcache[flat];
 }
 
 
@@ -661,6 +1043,15 @@ void R_InitSpriteLumps (void)
     lastspritelump = W_GetNumForName (DEH_String("S_END")) - 1;
     
     numspritelumps = lastspritelump - firstspritelump + 1;
+
+    if (baked != NULL)
+    {
+        spritewidth = BAKED(baked->spritewidthofs);
+        spriteoffset = BAKED(baked->spriteoffsetofs);
+        spritetopoffset = BAKED(baked->spritetopoffsetofs);
+        return;
+    }
+
     spritewidth = Z_Malloc (numspritelumps*sizeof(*spritewidth), PU_STATIC, 0);
     spriteoffset = Z_Malloc (numspritelumps*sizeof(*spriteoffset), PU_STATIC, 0);
     spritetopoffset = Z_Malloc (numspritelumps*sizeof(*spritetopoffset), PU_STATIC, 0);
@@ -688,11 +1079,188 @@ void R_InitColormaps (void)
 
     // Load in the light tables, 
     //  256 byte align tables.
+    // These are read for every pixel drawn, so keep a copy in fast RAM
+    // instead of using the WAD directly.
     lump = W_GetNumForName(DEH_String("COLORMAP"));
-    colormaps = W_CacheLumpNum(lump, PU_STATIC);
+    colormaps = Z_MallocHint(W_LumpLength(lump), PU_STATIC, NULL, MEM_FAST);
+    W_ReadLump(lump, colormaps);
+}
+
+
+
+//
+// R_CountTextures
+// Returns the number of textures in TEXTURE1/2 and the sum of their
+// widths in *totalwidth, or -1 if a texture directory is bad.
+//
+static int R_CountTextures (int *totalwidth)
+{
+    int		lumps[2];
+    int*	maptex;
+    int		length;
+    int		num;
+    int		offset;
+    int		count;
+    int		i;
+    int		j;
+
+    lumps[0] = W_GetNumForName (DEH_String("TEXTURE1"));
+    lumps[1] = W_CheckNumForName (DEH_String("TEXTURE2"));
+
+    count = 0;
+    *totalwidth = 0;
+
+    for (i=0 ; i<2 ; i++)
+    {
+	if (lumps[i] < 0)
+	    continue;
+
+	maptex = W_CacheLumpNum (lumps[i], PU_STATIC);
+	length = W_LumpLength (lumps[i]);
+	num = length >= 4 ? LONG(*maptex) : -1;
+
+	if (num < 0 || num > length / 4 - 1)
+	{
+	    W_ReleaseLumpNum (lumps[i]);
+	    return -1;
+	}
+
+	for (j=0 ; j<num ; j++)
+	{
+	    offset = LONG(maptex[j+1]);
+
+	    if (offset < 0 || offset > length - (int) sizeof(maptexture_t))
+	    {
+		W_ReleaseLumpNum (lumps[i]);
+		return -1;
+	    }
+
+	    *totalwidth += SHORT(((maptexture_t *) ((byte *) maptex + offset))->width);
+	}
+
+	count += num;
+	W_ReleaseLumpNum (lumps[i]);
+    }
+
+    return count;
 }
 
 
+//
+// R_BakedArrayFits
+// True if count elements of size bytes at ofs are aligned for them
+// and lie within the file.
+//
+static boolean R_BakedArrayFits (int ofs, int count, int size, int length)
+{
+    return ofs >= 0 && count >= 0
+	&& (ofs & (size - 1)) == 0
+	&& ofs <= length
+	&& count <= (length - ofs) / size;
+}
+
+
+//
+// R_BakedTablesValid
+// Checks an entry against the loaded textures and sprites before any
+// of it is used, so that anything that doesn't match falls back to
+// generating the tables.
+//
+static boolean R_BakedTablesValid (bakedtables_t *tables, int length)
+{
+    int		numtex;
+    int		totalwidth;
+    int		numsprites;
+    int		start;
+    int		end;
+
+    numtex = R_CountTextures (&totalwidth);
+
+    start = W_CheckNumForName (DEH_String("S_START"));
+    end = W_CheckNumForName (DEH_String("S_END"));
+    numsprites = end - start - 1;
+
+    return numtex >= 0 && start >= 0 && end >= 0
+	&& tables->numtextures == numtex
+	&& tables->totalwidth == totalwidth
+	&& tables->numspritelumps == numsprites
+	&& R_BakedArrayFits (tables->compositesizeofs, numtex, sizeof(int), length)
+	&& R_BakedArrayFits (tables->widthmaskofs, numtex, sizeof(int), length)
+	&& R_BakedArrayFits (tables->heightofs, numtex, sizeof(fixed_t), length)
+	&& R_BakedArrayFits (tables->spritewidthofs, numsprites, sizeof(fixed_t), length)
+	&& R_BakedArrayFits (tables->spriteoffsetofs, numsprites, sizeof(fixed_t), length)
+	&& R_BakedArrayFits (tables->spritetopoffsetofs, numsprites, sizeof(fixed_t), length)
+	&& R_BakedArrayFits (tables->columnlumpofs, totalwidth, sizeof(short), length)
+	&& R_BakedArrayFits (tables->columnofsofs, totalwidth, sizeof(unsigned short), length);
+}
+
+
+//
+// R_LoadBakedTables
+// Looks for tables baked for the loaded WADs, sets baked if found.
+//
+static void R_LoadBakedTables (void)
+{
+    wad_file_t*			file;
+    bakedtablesheader_t*	header;
+    bakedtablesentry_t*		entry;
+    sha1_digest_t		digest;
+    int				numentries;
+    int				offset;
+    int				i;
+
+    file = W_OpenFile (BAKED_TABLES_FILE);
+
+    if (file == NULL)
+	return;
+
+    // only useful if we can use it in place
+    if (file->mapped == NULL || file->length < sizeof(bakedtablesheader_t))
+    {
+	W_CloseFile (file);
+	return;
+    }
+
+    header = (bakedtablesheader_t *) file->mapped;
+    numentries = LONG(header->numentries);
+
+    if (strncmp(header->identification, "RTBL", 4)
+     || file->length < sizeof(bakedtablesheader_t) + numentries * sizeof(bakedtablesentry_t))
+    {
+	W_CloseFile (file);
+	return;
+    }
+
+    W_Checksum (digest);
+
+    entry = (bakedtablesentry_t *) (header + 1);
+
+    for (i=0 ; i<numentries ; i++, entry++)
+    {
+	offset = LONG(entry->offset);
+
+	if (memcmp(entry->sha1, digest, sizeof(digest)))
+	    continue;
+
+	if (((uintptr_t) (file->mapped + offset) & 3) == 0
+	 && offset >= 0
+	 && offset + sizeof(bakedtables_t) <= file->length
+	 && R_BakedTablesValid ((bakedtables_t *) (file->mapped + offset),
+				file->length))
+	{
+	    // the file stays open, the tables are used directly from it
+	    bakedfile = file->mapped;
+	    baked = (bakedtables_t *) (bakedfile + offset);
+	    return;
+	}
+
+	printf ("R_LoadBakedTables: baked tables don't match, ignoring them\n");
+	break;
+    }
+
+    W_CloseFile (file);
+}
+
 
 //
 // R_InitData
@@ -702,6 +1270,7 @@ void R_InitColormaps (void)
 //
 void R_InitData (void)
 {
+    R_LoadBakedTables ();
     R_InitTextures ();
     printf (".");
     R_InitFlats ();
@@ -792,28 +1361,63 @@ int	R_TextureNumForName (char* name)
 //
 // R_PrecacheLevel
 // Preloads all relevant graphics for the level.
+// Patches and sprites are used from the mapped WAD, so only lumps in
+// files that are not mapped need loading. The composites of the level's
+// multi-patch textures are built ahead of the first frame, most used
+// first, counting the lines around the player's start several times
+// over, for as many as fit in composite_cache_kb.
 //
 int		flatmemory;
 int		texturememory;
 int		spritememory;
 
+// Lines with their middle this close to the player's start
+#define PRECACHE_NEAR		(1024*FRACUNIT)
+
+// count this many times over
+#define PRECACHE_NEARWEIGHT	8
+
+static int*	precachescore;
+
+static int R_ComparePrecache (const void *a, const void *b)
+{
+    return precachescore[*(const int *)b] - precachescore[*(const int *)a];
+}
+
+static void R_PrecacheLump (int lump)
+{
+    if (lumpinfo[lump].wad_file->mapped == NULL)
+	W_CacheLumpNum (lump, PU_CACHE);
+}
+
 void R_PrecacheLevel (void)
 {
     char*		flatpresent;
-    char*		texturepresent;
+    int*		textureorder;
     char*		spritepresent;
 
     int			i;
     int			j;
     int			k;
     int			lump;
-    
+    int			weight;
+    int			numpresent;
+    int			numcomposites;
+    unsigned int	start;
+    unsigned int	time;
+    char		msg[48];
+
+    line_t*		line;
+    side_t*		side;
+    mobj_t*		mo;
     texture_t*		texture;
     thinker_t*		th;
     spriteframe_t*	sf;
 
     if (demoplayback)
 	return;
+
+    start = I_GetTimeUS ();
     
     // Precache flats.
     flatpresent = Z_Malloc(numflats, PU_STATIC, NULL);
@@ -833,48 +1437,91 @@ void R_PrecacheLevel (void)
 	{
 	    lump = firstflat + i;
 	    flatmemory += lumpinfo[lump].ptr->size;
-	    W_CacheLumpNum(lump, PU_CACHE);
+	    R_GetFlat(i);
 	}
     }
 
     Z_Free(flatpresent);
     
-    // Precache textures.
-    texturepresent = Z_Malloc(numtextures, PU_STATIC, NULL);
-    memset (texturepresent,0, numtextures);
-	
-    for (i=0 ; i<numsides ; i++)
+    // Precache textures, scoring each by the sidedefs that use it.
+    precachescore = Z_Malloc(numtextures * sizeof(*precachescore), PU_STATIC, NULL);
+    memset (precachescore, 0, numtextures * sizeof(*precachescore));
+
+    mo = players[consoleplayer].mo;
+
+    for (i=0, line=lines ; i<numlines ; i++, line++)
     {
-	texturepresent[sides[i].toptexture] = 1;
-	texturepresent[sides[i].midtexture] = 1;
-	texturepresent[sides[i].bottomtexture] = 1;
+	weight = 1;
+
+	if (mo != NULL
+	 && P_AproxDistance ((line->v1->x >> 1) + (line->v2->x >> 1) - mo->x,
+			     (line->v1->y >> 1) + (line->v2->y >> 1) - mo->y)
+	    < PRECACHE_NEAR)
+	{
+	    weight = PRECACHE_NEARWEIGHT;
+	}
+
+	for (j=0 ; j<2 ; j++)
+	{
+	    if (line->sidenum[j] == -1)
+		continue;
+
+	    side = &sides[line->sidenum[j]];
+	    precachescore[side->toptexture] += weight;
+	    precachescore[side->midtexture] += weight;
+	    precachescore[side->bottomtexture] += weight;
+	}
     }
 
-    // Sky texture is always present.
+    // Texture 0 is what "-" (no texture) maps to.
+    precachescore[0] = 0;
+
+    // Sky texture is always present, and drawn whenever
+    // any of it is in view.
     // Note that F_SKY1 is the name used to
     //  indicate a sky floor/ceiling as a flat,
     //  while the sky texture is stored like
     //  a wall texture, with an episode dependend
     //  name.
-    texturepresent[skytexture] = 1;
-	
-    texturememory = 0;
+    precachescore[skytexture] = INT_MAX / 2;
+
+    textureorder = Z_Malloc(numtextures * sizeof(*textureorder), PU_STATIC, NULL);
+    numpresent = 0;
+
     for (i=0 ; i<numtextures ; i++)
     {
-	if (!texturepresent[i])
-	    continue;
+	if (precachescore[i] > 0)
+	    textureorder[numpresent++] = i;
+    }
+
+    qsort (textureorder, numpresent, sizeof(*textureorder), R_ComparePrecache);
+
+    texturememory = 0;
+    numcomposites = 0;
+
+    for (i=0 ; i<numpresent ; i++)
+    {
+	k = textureorder[i];
+	texture = textures[k];
 
-	texture = textures[i];
-	
 	for (j=0 ; j<texture->patchcount ; j++)
-	{
-	    lump = texture->patches[j].patch;
-	    texturememory += lumpinfo[lump].ptr->size;
-	    W_CacheLumpNum(lump , PU_CACHE);
-	}
+	    R_PrecacheLump (texture->patches[j].patch);
+
+	if (texturecompositesize[k] == 0)
+	    continue;
+
+	// Skip what doesn't fit, something further down might.
+	if (composite_cache_kb > 0
+	 && texturememory + R_CompositeBlockSize(k) > composite_cache_kb * 1024)
+	    continue;
+
+	R_PrecacheComposite (k);
+	texturememory += R_CompositeBlockSize(k);
+	numcomposites++;
     }
 
-    Z_Free(texturepresent);
+    Z_Free(textureorder);
+    Z_Free(precachescore);
     
     // Precache sprites.
     spritepresent = Z_Malloc(numsprites, PU_STATIC, NULL);
@@ -899,12 +1546,19 @@ void R_PrecacheLevel (void)
 	    {
 		lump = firstspritelump + sf->lump[k];
 		spritememory += lumpinfo[lump].ptr->size;
-		W_CacheLumpNum(lump , PU_CACHE);
+		R_PrecacheLump (lump);
 	    }
 	}
     }
 
     Z_Free(spritepresent);
+
+    time = I_GetTimeUS () - start;
+
+    M_snprintf (msg, sizeof(msg), "precache %i composites %iK (%u.%ums)",
+		numcomposites, texturememory / 1024, time / 1000, (time / 100) % 10);
+    printf ("R_PrecacheLevel: %s\n", msg);
+    PROFILE_EVENT (msg);
 }
 
 
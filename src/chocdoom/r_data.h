@@ -32,6 +32,35 @@ R_GetColumn
   int		col );
 
 
+// Composite texture cache, see r_data.c
+extern int composite_cache_kb;
+extern int composite_columns;
+
+typedef struct
+{
+    // Each composite texture drawn in a frame is a hit if it was in the
+    // cache when first drawn in the frame, or a miss for every time it
+    // has to be built (R_PrecacheLevel doesn't count)
+    unsigned int	hits;
+    unsigned int	misses;
+    unsigned int	regenerations;	// misses for composites built before
+    unsigned int	evictions;	// composites freed to stay in budget
+    int			bytes;		// held by the cache
+    int			peakbytes;
+} compositestats_t;
+
+void R_GetCompositeStats (compositestats_t *stats);
+
+// Clears the counters, but not what the cache is holding
+void R_ResetCompositeStats (void);
+
+// Frees all of the composites, called by P_SetupLevel
+void R_FlushComposites (void);
+
+
+// Flat data for drawing, by flat number.
+byte *R_GetFlat (int flat);
+
 // I/O, setting up the stuff.
 void R_InitData (void);
 void R_PrecacheLevel (void);
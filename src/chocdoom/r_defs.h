@@ -24,6 +24,8 @@
 // Screenwidth.
 #include "doomdef.h"
 
+#include "doomfeatures.h"
+
 // Some more or less basic data types
 // we depend on.
 #include "m_fixed.h"
@@ -38,6 +40,8 @@
 
 #include "v_patch.h"
 
+#include "z_zone.h"
+
 
 
 
@@ -48,6 +52,8 @@
 #define SIL_TOP			2
 #define SIL_BOTH		3
 
+// Upper limits for the size estimated from the map, the pools can grow
+// past these during the level.
 #define MAXDRAWSEGS		256
 
 
@@ -178,9 +184,11 @@ typedef struct line_s
     vertex_t*	v1;
     vertex_t*	v2;
 
+#ifdef FEATURE_FAST_LINES
     // Precalculated v2 - v1 for side checking.
-    //fixed_t	dx;
-    //fixed_t	dy;
+    fixed_t	dx;
+    fixed_t	dy;
+#endif
 
     // Animation related.
     short	flags;
@@ -198,10 +206,12 @@ typedef struct line_s
     //  of the LineDef.
     short	bbox[4];
 
+#ifdef FEATURE_FAST_LINES
     // Front and back sector.
     // Note: redundant? Can be retrieved from SideDefs.
-    //sector_t*	frontsector;
-    //sector_t*	backsector;
+    sector_t*	frontsector;
+    sector_t*	backsector;
+#endif
 
     // if == validcount, already checked
     int		validcount;
@@ -210,6 +220,22 @@ typedef struct line_s
     //void*	specialdata;		
 } line_t;
 
+// Without FEATURE_FAST_LINES these are worked out from the vertexes and
+// SideDefs every time, with it they are read from the line
+#ifdef FEATURE_FAST_LINES
+#define LINE_DX(line)		((line)->dx)
+#define LINE_DY(line)		((line)->dy)
+#define LINE_FRONTSECTOR(line)	((line)->frontsector)
+#define LINE_BACKSECTOR(line)	((line)->backsector)
+#else
+#define LINE_DX(line)		((line)->v2->x - (line)->v1->x)
+#define LINE_DY(line)		((line)->v2->y - (line)->v1->y)
+#define LINE_FRONTSECTOR(line) \
+    ((line)->sidenum[0] == -1 ? (sector_t *) 0 : sides[(line)->sidenum[0]].sector)
+#define LINE_BACKSECTOR(line) \
+    ((line)->sidenum[1] == -1 ? (sector_t *) 0 : sides[(line)->sidenum[1]].sector)
+#endif
+
 
 
 
@@ -232,27 +258,40 @@ typedef struct subsector_s
 
 //
 // The LineSeg.
+// Indexes rather than pointers, so that a precompiled level (see
+// P_LoadPrecompiled) can be used straight from the WAD. Use the SEG_
+// macros to get at what they refer to.
 //
 typedef struct
 {
-    vertex_t*	v1;
-    vertex_t*	v2;
+    unsigned short	v1;	// vertexes
+    unsigned short	v2;
     
     /*fixed_t*/short	offset;
 
     /*angle_t*/short	angle;
 
-    side_t*	sidedef;
-    line_t*	linedef;
+    unsigned short	sidedef;	// sides
+    unsigned short	linedef;	// lines
 
     // Sector references.
     // Could be retrieved from linedef, too.
-    // backsector is NULL for one sided lines
-    //sector_t*	frontsector;
-    sector_t*	backsector;
+    // backsector is NO_INDEX for one sided lines
+    unsigned short	frontsector;	// sectors
+    unsigned short	backsector;
     
 } seg_t;
 
+#define NO_INDEX		0xffff
+
+#define SEG_V1(seg)		(&vertexes[(seg)->v1])
+#define SEG_V2(seg)		(&vertexes[(seg)->v2])
+#define SEG_SIDEDEF(seg)	(&sides[(seg)->sidedef])
+#define SEG_LINEDEF(seg)	(&lines[(seg)->linedef])
+#define SEG_FRONTSECTOR(seg)	(&sectors[(seg)->frontsector])
+#define SEG_BACKSECTOR(seg) \
+    ((seg)->backsector == NO_INDEX ? (sector_t *) 0 : &sectors[(seg)->backsector])
+
 
 
 //
@@ -422,8 +461,11 @@ typedef struct
 //
 // Now what is a visplane, anyway?
 // 
-typedef struct
+typedef struct visplane_s
 {
+  // next in the R_FindPlane hash chain
+  struct visplane_s*	next;
+
   fixed_t		height;
   int			picnum;
   short			lightlevel;
@@ -445,6 +487,23 @@ typedef struct
 } visplane_t;
 
 
+//
+// Per-level pool of one of the above, allocated by R_SetupLevel.
+// Anything that doesn't fit is dropped and counted, and the pool is
+// grown at the start of the next frame.
+//
+typedef struct
+{
+    char*	name;
+    int		elemsize;
+    memspeed_t	speed;
+
+    int		size;		// in elements
+    int		dropped;	// this frame
+    int		totaldropped;	// this level
+} rpool_t;
+
+
 
 
 #endif
@@ -53,6 +53,34 @@
 //  and the total size == width*height*depth/8.,
 //
 
+// With FEATURE_TRANSPOSED_VIEW the view is drawn into viewbuffer one
+// column after another, so that the pixels of a column are contiguous,
+// and R_TransposeView copies it to the screen once it is finished.
+// COLUMNSTEP and ROWSTEP are the distances between vertically and
+// horizontally adjacent pixels of the view.
+
+#ifdef FEATURE_TRANSPOSED_VIEW
+#define VIEWPITCH		SCREENHEIGHT
+#define COLUMNSTEP		1
+#define ROWSTEP			VIEWPITCH
+
+static byte *viewbuffer = NULL;
+
+// The view can also be drawn a strip of columns at a time (strip_width)
+// into stripbuffer, which is placed in fast memory, and each strip is
+// transposed to the screen when it is finished.
+
+static byte *stripbuffer = NULL;
+static int stripbuffersize = 0;
+
+// Buffer the current strip is drawn into, column stripstart at offset 0
+
+static byte *stripdest;
+#else
+#define COLUMNSTEP		SCREENWIDTH
+#define ROWSTEP			1
+#endif
+
 
 byte*		viewimage; 
 int		viewwidth;
@@ -63,6 +91,11 @@ int		viewwindowy;
 byte*		ylookup[MAXHEIGHT]; 
 int		columnofs[MAXWIDTH]; 
 
+// Columns of the view being rendered, stripend is exclusive. This is
+// the whole view unless it is drawn in strips.
+int		stripstart;
+int		stripend;
+
 // Color tables for different players,
 //  translate a limited part to another
 //  (color ramps used for  suit colors).
@@ -138,7 +171,7 @@ void R_DrawColumn (void)
 	//  using a lighting/special effects LUT.
 	*dest = dc_colormap[dc_source[(frac>>FRACBITS)&127]];
 	
-	dest += SCREENWIDTH; 
+	dest += COLUMNSTEP; 
 	frac += fracstep;
 	
     } while (count--); 
@@ -243,8 +276,8 @@ void R_DrawColumnLow (void)
     {
 	// Hack. Does not work corretly.
 	*dest2 = *dest = dc_colormap[dc_source[(frac>>FRACBITS)&127]];
-	dest += SCREENWIDTH;
-	dest2 += SCREENWIDTH;
+	dest += COLUMNSTEP;
+	dest2 += COLUMNSTEP;
 	frac += fracstep; 
 
     } while (count--);
@@ -255,7 +288,7 @@ void R_DrawColumnLow (void)
 // Spectre/Invisibility.
 //
 #define FUZZTABLE		50 
-#define FUZZOFF	(SCREENWIDTH)
+#define FUZZOFF	(COLUMNSTEP)
 
 
 int	fuzzoffset[FUZZTABLE] =
@@ -331,7 +364,7 @@ void R_DrawFuzzColumn (void)
 	if (++fuzzpos == FUZZTABLE) 
 	    fuzzpos = 0;
 	
-	dest += SCREENWIDTH;
+	dest += COLUMNSTEP;
 
 	frac += fracstep; 
     } while (count--); 
@@ -398,8 +431,8 @@ void R_DrawFuzzColumnLow (void)
 	if (++fuzzpos == FUZZTABLE) 
 	    fuzzpos = 0;
 	
-	dest += SCREENWIDTH;
-	dest2 += SCREENWIDTH;
+	dest += COLUMNSTEP;
+	dest2 += COLUMNSTEP;
 
 	frac += fracstep; 
     } while (count--); 
@@ -459,7 +492,7 @@ void R_DrawTranslatedColumn (void)
 	// Thus the "green" ramp of the player 0 sprite
 	//  is mapped to gray, red, black/indigo. 
 	*dest = dc_colormap[dc_translation[dc_source[frac>>FRACBITS]]];
-	dest += SCREENWIDTH;
+	dest += COLUMNSTEP;
 	
 	frac += fracstep; 
     } while (count--); 
@@ -510,8 +543,8 @@ void R_DrawTranslatedColumnLow (void)
 	//  is mapped to gray, red, black/indigo. 
 	*dest = dc_colormap[dc_translation[dc_source[frac>>FRACBITS]]];
 	*dest2 = dc_colormap[dc_translation[dc_source[frac>>FRACBITS]]];
-	dest += SCREENWIDTH;
-	dest2 += SCREENWIDTH;
+	dest += COLUMNSTEP;
+	dest2 += COLUMNSTEP;
 	
 	frac += fracstep; 
     } while (count--); 
@@ -631,7 +664,8 @@ void R_DrawSpan (void)
 
 	// Lookup pixel from flat texture tile,
 	//  re-index using light/colormap.
-	*dest++ = ds_colormap[ds_source[spot]];
+	*dest = ds_colormap[ds_source[spot]];
+	dest += ROWSTEP;
 
         position += step;
 
@@ -758,8 +792,10 @@ void R_DrawSpanLow (void)
 
 	// Lowres/blocky mode does it twice,
 	//  while scale is adjusted appropriately.
-	*dest++ = ds_colormap[ds_source[spot]];
-	*dest++ = ds_colormap[ds_source[spot]];
+	*dest = ds_colormap[ds_source[spot]];
+	dest += ROWSTEP;
+	*dest = ds_colormap[ds_source[spot]];
+	dest += ROWSTEP;
 
 	position += step;
 
@@ -778,27 +814,128 @@ R_InitBuffer
 ( int		width,
   int		height ) 
 { 
-    int		i; 
-
     // Handle resize,
     //  e.g. smaller view windows
     //  with border and/or status bar.
     viewwindowx = (SCREENWIDTH-width) >> 1; 
 
-    // Column offset. For windows.
-    for (i=0 ; i<width ; i++) 
-	columnofs[i] = viewwindowx + i;
-
     // Samw with base row offset.
     if (width == SCREENWIDTH) 
 	viewwindowy = 0; 
     else 
 	viewwindowy = (SCREENHEIGHT-SBARHEIGHT-height) >> 1; 
 
+#ifdef FEATURE_TRANSPOSED_VIEW
+    if (viewbuffer == NULL)
+    {
+        viewbuffer = Z_Malloc(SCREENWIDTH * VIEWPITCH, PU_STATIC, NULL);
+    }
+
+    R_SetViewStrip (0, width >> detailshift);
+#else
+    int		i; 
+
+    stripstart = 0;
+    stripend = width >> detailshift;
+
+    // Column offset. For windows.
+    for (i=0 ; i<width ; i++) 
+	columnofs[i] = viewwindowx + i;
+
     // Preclaculate all row offsets.
     for (i=0 ; i<height ; i++) 
 	ylookup[i] = I_VideoBuffer + (i+viewwindowy)*SCREENWIDTH; 
+#endif
 } 
+
+#ifdef FEATURE_TRANSPOSED_VIEW
+//
+// R_SetViewStrip
+// Renders the view columns x1 to x2-1 from now on. Anything narrower
+//  than the view is drawn into stripbuffer.
+//
+void
+R_SetViewStrip
+( int		x1,
+  int		x2 )
+{
+    int		size;
+    int		base;
+    int		i;
+
+    stripstart = x1;
+    stripend = x2;
+
+    if (x1 == 0 && x2 == viewwidth)
+    {
+	stripdest = viewbuffer;
+    }
+    else
+    {
+	size = ((x2 - x1) << detailshift) * VIEWPITCH;
+
+	if (size > stripbuffersize)
+	{
+	    if (stripbuffer != NULL)
+		Z_Free (stripbuffer);
+
+	    stripbuffer = Z_MallocHint (size, PU_STATIC, NULL, MEM_FAST);
+	    stripbuffersize = size;
+	}
+
+	stripdest = stripbuffer;
+    }
+
+    // Columns are in screen pixels, so twice as many in low detail.
+    base = x1 << detailshift;
+
+    for (i=base ; i<(x2 << detailshift) ; i++)
+	columnofs[i] = (i - base)*VIEWPITCH;
+
+    for (i=0 ; i<viewheight ; i++) 
+	ylookup[i] = stripdest + i; 
+}
+
+//
+// R_TransposeView
+// Copies the finished strip (or view) to the screen. Four columns
+//  are read at a time so that each screen row gets a 4 byte write.
+//
+void R_TransposeView (void)
+{
+    byte*	src0;
+    byte*	src1;
+    byte*	src2;
+    byte*	src3;
+    byte*	dest;
+    int		x1;
+    int		x2;
+    int		x;
+    int		y;
+
+    // strips (and scaledviewwidth) are multiples of 4 pixels wide
+    x1 = stripstart << detailshift;
+    x2 = stripend << detailshift;
+
+    for (x=x1 ; x<x2 ; x+=4)
+    {
+	src0 = stripdest + (x - x1)*VIEWPITCH;
+	src1 = src0 + VIEWPITCH;
+	src2 = src1 + VIEWPITCH;
+	src3 = src2 + VIEWPITCH;
+	dest = I_VideoBuffer + viewwindowy*SCREENWIDTH + viewwindowx + x;
+
+	for (y=0 ; y<viewheight ; y++)
+	{
+	    dest[0] = src0[y];
+	    dest[1] = src1[y];
+	    dest[2] = src2[y];
+	    dest[3] = src3[y];
+	    dest += SCREENWIDTH;
+	}
+    }
+}
+#endif
  
  
 
@@ -926,9 +1063,11 @@ R_VideoErase
   //  a 32bit CPU, as GNU GCC/Linux libc did
   //  at one point.
 
-    if (background_buffer != NULL)
+    if (background_buffer != NULL && count > 0)
     {
         memcpy(I_VideoBuffer + ofs, background_buffer + ofs, count); 
+        V_MarkRect (0, ofs / SCREENWIDTH, SCREENWIDTH,
+                    (ofs + count - 1) / SCREENWIDTH - ofs / SCREENWIDTH + 1);
     }
 } 
 
@@ -99,6 +99,14 @@ void R_FillBackScreen (void);
 // If the view size is not full screen, draws a border around it.
 void R_DrawViewBorder (void);
 
+#ifdef FEATURE_TRANSPOSED_VIEW
+// Restricts rendering to the view columns x1 to x2-1.
+void R_SetViewStrip (int x1, int x2);
+
+// Copies the current strip (or the whole view) to the screen.
+void R_TransposeView (void);
+#endif
+
 
 
 #endif
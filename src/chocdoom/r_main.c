@@ -28,12 +28,17 @@
 
 #include "doomdef.h"
 #include "d_loop.h"
+#include "i_timer.h"
 
 #include "m_bbox.h"
+#include "m_misc.h"
 #include "m_menu.h"
+#include "m_profile.h"
 
+#include "p_local.h"
 #include "r_local.h"
 #include "r_sky.h"
+#include "st_stuff.h"
 
 
 
@@ -59,6 +64,7 @@ int			centery;
 fixed_t			centerxfrac;
 fixed_t			centeryfrac;
 fixed_t			projection;
+fixed_t			projectiony;
 
 // just for profiling purposes
 int			framecount;	
@@ -215,11 +221,11 @@ R_PointOnSegSide
     fixed_t	left;
     fixed_t	right;
 	
-    lx = line->v1->x;
-    ly = line->v1->y;
+    lx = SEG_V1(line)->x;
+    ly = SEG_V1(line)->y;
 	
-    ldx = line->v2->x - lx;
-    ldy = line->v2->y - ly;
+    ldx = SEG_V2(line)->x - lx;
+    ldy = SEG_V2(line)->y - ly;
 	
     if (!ldx)
     {
@@ -484,7 +490,7 @@ fixed_t R_ScaleFromGlobalAngle (angle_t visangle)
     // both sines are allways positive
     sinea = finesine[anglea>>ANGLETOFINESHIFT];	
     sineb = finesine[angleb>>ANGLETOFINESHIFT];
-    num = FixedMul(projection,sineb)<<detailshift;
+    num = FixedMul(projectiony,sineb)<<detailshift;
     den = FixedMul(rw_distance,sinea);
 
     if (den > num>>16)
@@ -688,7 +694,7 @@ void R_ExecuteSetViewSize (void)
     else
     {
 	scaledviewwidth = setblocks*32;
-	viewheight = (setblocks*168/10)&~7;
+	viewheight = (setblocks*(SCREENHEIGHT-ST_HEIGHT)/10)&~7;
     }
     
     detailshift = setdetail;
@@ -699,6 +705,7 @@ void R_ExecuteSetViewSize (void)
     centerxfrac = centerx<<FRACBITS;
     centeryfrac = centery<<FRACBITS;
     projection = centerxfrac;
+    projectiony = PIXELASPECT(projection);
 
     if (!detailshift)
     {
@@ -732,7 +739,7 @@ void R_ExecuteSetViewSize (void)
     {
 	dy = ((i-viewheight/2)<<FRACBITS)+FRACUNIT/2;
 	dy = abs(dy);
-	yslope[i] = FixedDiv ( (viewwidth<<detailshift)/2*FRACUNIT, dy);
+	yslope[i] = FixedDiv ( PIXELASPECT((viewwidth<<detailshift)/2*FRACUNIT), dy);
     }
 	
     for (i=0 ; i<viewwidth ; i++)
@@ -763,6 +770,114 @@ void R_ExecuteSetViewSize (void)
 
 
 
+//
+// R_AdaptDetail
+// Drops to low detail, then to a smaller view, when frames keep taking
+// longer than adaptive_fps allows and goes back towards the menu settings
+// once they are comfortably quicker again.
+//
+int		adaptive_detail = 0;
+int		adaptive_fps = 30;
+int		adaptive_shrink = 0;
+
+// Frames in a row over budget before dropping a level, and under 3/4 of
+// the budget before raising one. The gap between the two is the
+// hysteresis, so that a borderline scene does not flip every frame.
+#define ADAPTDROPFRAMES		8
+#define ADAPTRAISEFRAMES	70
+
+// 0 is the menu settings, the first level is low detail (unless that is
+// already set), then one screen block less per level
+static int		adaptlevel;
+static int		adaptover;
+static int		adaptunder;
+static unsigned int	adaptlast;
+static boolean		adaptsampled;
+
+void R_AdaptDetail (boolean sample)
+{
+    unsigned int	now;
+    unsigned int	frametime;
+    unsigned int	budget;
+    int			maxlevel;
+    int			level;
+    int			shrink;
+    int			blocks;
+    char		msg[48];
+
+    now = I_GetTimeUS ();
+    frametime = now - adaptlast;
+    adaptlast = now;
+
+    // vanilla's smallest view is 3 blocks
+    maxlevel = screenblocks - 3;
+    if (adaptive_shrink < maxlevel)
+	maxlevel = adaptive_shrink > 0 ? adaptive_shrink : 0;
+    maxlevel += !detailLevel;
+    level = adaptlevel;
+
+    if (!adaptive_detail || adaptive_fps <= 0)
+    {
+	level = 0;
+	sample = false;
+    }
+
+    if (level > maxlevel)
+	level = maxlevel;
+
+    // the first frame after a gap (menus, wipes, level loads) is not a
+    // frame time
+    if (!sample || !adaptsampled)
+    {
+	adaptover = adaptunder = 0;
+    }
+    else
+    {
+	budget = 1000000 / adaptive_fps;
+
+	if (frametime > budget)
+	{
+	    adaptover++;
+	    adaptunder = 0;
+	}
+	else if (frametime < budget * 3 / 4)
+	{
+	    adaptunder++;
+	    adaptover = 0;
+	}
+	else
+	{
+	    adaptover = adaptunder = 0;
+	}
+
+	if (adaptover >= ADAPTDROPFRAMES && level < maxlevel)
+	    level++;
+	else if (adaptunder >= ADAPTRAISEFRAMES && level > 0)
+	    level--;
+    }
+
+    if (level != adaptlevel)
+    {
+	M_snprintf (msg, sizeof(msg), "detail %i -> %i (%u.%ums)",
+		    adaptlevel, level, frametime / 1000, (frametime / 100) % 10);
+	printf ("R_AdaptDetail: %s\n", msg);
+	PROFILE_EVENT (msg);
+
+	adaptlevel = level;
+	adaptover = adaptunder = 0;
+    }
+
+    adaptsampled = sample;
+
+    shrink = level - !detailLevel;
+    blocks = screenblocks - (shrink > 0 ? shrink : 0);
+
+    if (blocks != setblocks || (detailLevel || level) != setdetail)
+	R_SetViewSize (blocks, detailLevel || level);
+}
+
+
+
 //
 // R_Init
 //
@@ -792,6 +907,132 @@ void R_Init (void)
 }
 
 
+//
+// RENDERER POOLS
+//
+
+// How much the pools can grow by over a level, in bytes
+#define POOL_RESERVE	(32 * 1024)
+
+static int		pool_reserve;
+
+static rpool_t*		pools[] =
+{
+    &visplanepool,
+    &openingpool,
+    &drawsegpool,
+    &vissprpool
+};
+
+#define NUM_POOLS	(sizeof(pools) / sizeof(*pools))
+
+static int Clamp (int x, int min, int max)
+{
+    if (x < min)
+	return min;
+    if (x > max)
+	return max;
+    return x;
+}
+
+static void R_AllocPool (rpool_t* pool, void** data, int size)
+{
+    pool->size = size;
+    pool->dropped = pool->totaldropped = 0;
+
+    Z_MallocHint (size * pool->elemsize, PU_LEVEL, data, pool->speed);
+}
+
+//
+// R_CheckPool
+// Called at frame start, grows a pool that overflowed in the last
+// frame if there is anything left in the reserve.
+//
+void R_CheckPool (rpool_t* pool, void** data)
+{
+    int		grow;
+
+    if (!pool->dropped)
+	return;
+
+    pool->totaldropped += pool->dropped;
+
+    grow = pool->size / 2;
+
+    if (grow < pool->dropped)
+	grow = pool->dropped;
+
+    if (grow * pool->elemsize > pool_reserve)
+	grow = pool_reserve / pool->elemsize;
+
+    pool->dropped = 0;
+
+    if (grow <= 0)
+	return;
+
+    // the pool is empty between frames, so there is nothing to copy
+    Z_Free (*data);
+
+    if (Z_TryMalloc ((pool->size + grow) * pool->elemsize, PU_LEVEL,
+		     data, pool->speed))
+    {
+	pool->size += grow;
+	pool_reserve -= grow * pool->elemsize;
+	printf ("R_CheckPool: %s grown to %i\n", pool->name, pool->size);
+    }
+    else
+    {
+	// no room, stop trying
+	pool_reserve = 0;
+	Z_MallocHint (pool->size * pool->elemsize, PU_LEVEL, data, pool->speed);
+    }
+}
+
+
+//
+// R_SetupLevel
+// Allocates the renderer pools for a newly loaded level, sized from the
+// number of sectors, segs and things in it.
+//
+void R_SetupLevel (void)
+{
+    thinker_t*	th;
+    int		numthings;
+    int		i;
+
+    for (i = 0; i < NUM_POOLS; i++)
+    {
+	if (pools[i]->totaldropped)
+	{
+	    printf ("R_SetupLevel: %i %s dropped in the last level\n",
+		    pools[i]->totaldropped, pools[i]->name);
+	}
+    }
+
+    numthings = 0;
+
+    for (th = thinkercap.next ; th != &thinkercap ; th=th->next)
+    {
+	if (th->function.acp1 == (actionf_p1)P_MobjThinker)
+	    numthings++;
+    }
+
+    R_AllocPool (&visplanepool, (void **)&visplanes,
+		 Clamp(24 + numsectors / 4, 32, MAXVISPLANES));
+    R_AllocPool (&openingpool, (void **)&openings,
+		 visplanepool.size * SCREENWIDTH / 2);
+    R_AllocPool (&drawsegpool, (void **)&drawsegs,
+		 Clamp(64 + numsegs / 8, 96, MAXDRAWSEGS));
+    R_AllocPool (&vissprpool, (void **)&vissprites,
+		 Clamp(16 + numthings / 4, 32, MAXVISSPRITES));
+
+    pool_reserve = POOL_RESERVE;
+
+    printf ("R_SetupLevel: %i visplanes, %i openings, %i drawsegs, %i vissprites\n",
+	    visplanepool.size, openingpool.size, drawsegpool.size, vissprpool.size);
+}
+
+
 //
 // R_PointInSubsector
 //
@@ -865,10 +1106,15 @@ void R_SetupFrame (player_t* player)
 //
 // R_RenderView
 //
-void R_RenderPlayerView (player_t* player)
-{	
-    R_SetupFrame (player);
 
+// If non-zero, the view is drawn in strips this many pixels wide (rounded
+// down to a multiple of 4), each in fast memory, when built with
+// FEATURE_TRANSPOSED_VIEW
+int			strip_width = 0;
+
+// Renders the columns from stripstart to stripend
+static void R_RenderStrip (void)
+{
     // Clear buffers.
     R_ClearClipSegs ();
     R_ClearDrawSegs ();
@@ -879,18 +1125,62 @@ void R_RenderPlayerView (player_t* player)
     NetUpdate ();
 
     // The head node is the last node output.
+    PROFILE_BEGIN(prof_bsp);
     R_RenderBSPNode (numnodes-1);
+    PROFILE_END(prof_bsp);
     
     // Check for new console commands.
     NetUpdate ();
     
+    PROFILE_BEGIN(prof_planes);
     R_DrawPlanes ();
+    PROFILE_END(prof_planes);
     
     // Check for new console commands.
     NetUpdate ();
     
+    PROFILE_BEGIN(prof_masked);
     R_DrawMasked ();
+    PROFILE_END(prof_masked);
+
+#ifdef FEATURE_TRANSPOSED_VIEW
+    PROFILE_BEGIN(prof_transpose);
+    R_TransposeView ();
+    PROFILE_END(prof_transpose);
+#endif
 
     // Check for new console commands.
     NetUpdate ();				
 }
+
+void R_RenderPlayerView (player_t* player)
+{	
+#ifdef FEATURE_TRANSPOSED_VIEW
+    int		width;
+    int		x;
+#endif
+
+    R_SetupFrame (player);
+
+#ifdef FEATURE_TRANSPOSED_VIEW
+    width = (strip_width & ~3) >> detailshift;
+
+    if (width > 0 && width < viewwidth)
+    {
+	for (x=0 ; x<viewwidth ; x+=width)
+	{
+	    R_SetViewStrip (x, x+width < viewwidth ? x+width : viewwidth);
+
+	    // sprites are only added once per sector per pass
+	    validcount++;
+
+	    R_RenderStrip ();
+	}
+
+	R_SetViewStrip (0, viewwidth);
+	return;
+    }
+#endif
+
+    R_RenderStrip ();
+}
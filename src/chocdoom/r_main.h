@@ -20,6 +20,7 @@
 #ifndef __R_MAIN__
 #define __R_MAIN__
 
+#include "doomfeatures.h"
 #include "d_player.h"
 #include "r_data.h"
 
@@ -43,9 +44,24 @@ extern int		centery;
 extern fixed_t		centerxfrac;
 extern fixed_t		centeryfrac;
 extern fixed_t		projection;
+extern fixed_t		projectiony;
+
+// Vertical scale for a horizontal one (and step for a horizontal
+// step). Rendering natively at 320x240 gives square pixels, where the
+// 320x200 view is stretched by 6/5 on the way to the screen.
+#ifdef FEATURE_NATIVE_SCREEN
+#define PIXELASPECT(x)	((x) * 6 / 5)
+#define PIXELASPECTINV(x)	((x) * 5 / 6)
+#else
+#define PIXELASPECT(x)	(x)
+#define PIXELASPECTINV(x)	(x)
+#endif
 
 extern int		validcount;
 
+// Frames rendered, for the composite texture cache
+extern int		framecount;
+
 extern int		linecount;
 extern int		loopcount;
 
@@ -157,4 +173,20 @@ void R_Init (void);
 // Called by M_Responder.
 void R_SetViewSize (int blocks, int detail);
 
+// Called by D_Display each frame, sample is false for frames that should
+// not count (menus, automap, other game states).
+void R_AdaptDetail (boolean sample);
+
+extern int		adaptive_detail;
+extern int		adaptive_fps;
+extern int		adaptive_shrink;
+
+extern int		strip_width;
+
+// Called by P_SetupLevel.
+void R_SetupLevel (void);
+
+// Called at frame start by the owner of each pool.
+void R_CheckPool (rpool_t* pool, void** data);
+
 #endif
@@ -42,17 +42,34 @@ planefunction_t		ceilingfunc;
 //
 
 // Here comes the obnoxious "visplane".
-#define MAXVISPLANES	128 / 2
-visplane_t		visplanes[MAXVISPLANES];
+visplane_t*		visplanes;
 visplane_t*		lastvisplane;
 visplane_t*		floorplane;
 visplane_t*		ceilingplane;
 
+rpool_t			visplanepool = {"visplanes", sizeof(visplane_t), MEM_NORMAL};
+
+// planes that didn't fit go here and aren't drawn
+static visplane_t	overflowplane;
+
+// R_FindPlane lookup, only the first plane with each height/picnum/light
+// is in here, later ones are split off it by R_CheckPlane
+#define VISPLANEHASHSIZE	64
+#define VisplaneHash(height, picnum, lightlevel) \
+    ((unsigned int)(((height) >> FRACBITS) * 7 + (picnum) * 3 + (lightlevel)) \
+     & (VISPLANEHASHSIZE - 1))
+
+static visplane_t*	visplanehash[VISPLANEHASHSIZE];
+
+// scan every plane like vanilla instead, for doom-benchmark to compare
+boolean			visplanelinear = false;
+
 // ?
-#define MAXOPENINGS	SCREENWIDTH*64 / 2
-short			openings[MAXOPENINGS];
+short*			openings;
 short*			lastopening;
 
+rpool_t			openingpool = {"openings", sizeof(short), MEM_NORMAL};
+
 
 //
 // Clip values are the solid pixel bounding the range.
@@ -187,8 +204,13 @@ void R_ClearPlanes (void)
 	ceilingclip[i] = -1;
     }
 
+    R_CheckPool (&visplanepool, (void **)&visplanes);
+    R_CheckPool (&openingpool, (void **)&openings);
+
     lastvisplane = visplanes;
     lastopening = openings;
+
+    memset (visplanehash, 0, sizeof(visplanehash));
     
     // texture calculation
     memset (cachedheight, 0, sizeof(cachedheight));
@@ -204,6 +226,47 @@ void R_ClearPlanes (void)
 
 
 
+//
+// R_OverflowPlane
+// Used when there are no more visplanes, nothing in it is drawn.
+//
+static visplane_t* R_OverflowPlane (visplane_t* pl, int minx, int maxx)
+{
+    visplanepool.dropped++;
+
+    overflowplane.height = pl->height;
+    overflowplane.picnum = pl->picnum;
+    overflowplane.lightlevel = pl->lightlevel;
+    overflowplane.minx = minx;
+    overflowplane.maxx = maxx;
+
+    memset (overflowplane.top,0xff,sizeof(overflowplane.top));
+
+    return &overflowplane;
+}
+
+
+//
+// R_NewOpenings
+// Returns space for count openings, or NULL if there is no more.
+//
+short* R_NewOpenings (int count)
+{
+    short*	result;
+
+    if (lastopening + count > openings + openingpool.size)
+    {
+	openingpool.dropped += count;
+	return NULL;
+    }
+
+    result = lastopening;
+    lastopening += count;
+
+    return result;
+}
+
+
 //
 // R_FindPlane
 //
@@ -214,31 +277,54 @@ R_FindPlane
   int		lightlevel )
 {
     visplane_t*	check;
+    unsigned int hash;
 	
     if (picnum == skyflatnum)
     {
 	height = 0;			// all skys map together
 	lightlevel = 0;
     }
+
+    hash = VisplaneHash(height, picnum, lightlevel);
 	
-    for (check=visplanes; check<lastvisplane; check++)
+    if (visplanelinear)
     {
-	if (height == check->height
-	    && picnum == check->picnum
-	    && lightlevel == check->lightlevel)
+	for (check=visplanes; check<lastvisplane; check++)
 	{
-	    break;
+	    if (height == check->height
+		&& picnum == check->picnum
+		&& lightlevel == check->lightlevel)
+	    {
+		return check;
+	    }
+	}
+    }
+    else
+    {
+	for (check=visplanehash[hash]; check; check=check->next)
+	{
+	    if (height == check->height
+		&& picnum == check->picnum
+		&& lightlevel == check->lightlevel)
+	    {
+		return check;
+	    }
 	}
     }
-    
-			
-    if (check < lastvisplane)
-	return check;
 		
-    if (lastvisplane - visplanes == MAXVISPLANES)
-	I_Error ("R_FindPlane: no more visplanes");
+    if (lastvisplane - visplanes == visplanepool.size)
+    {
+	overflowplane.height = height;
+	overflowplane.picnum = picnum;
+	overflowplane.lightlevel = lightlevel;
+
+	return R_OverflowPlane (&overflowplane, SCREENWIDTH, -1);
+    }
 		
-    lastvisplane++;
+    check = lastvisplane++;
+
+    check->next = visplanehash[hash];
+    visplanehash[hash] = check;
 
     check->height = height;
     check->picnum = picnum;
@@ -303,6 +389,9 @@ R_CheckPlane
     }
 	
     // make a new visplane
+    if (lastvisplane - visplanes == visplanepool.size)
+	return R_OverflowPlane (pl, start, stop);
+
     lastvisplane->height = pl->height;
     lastvisplane->picnum = pl->picnum;
     lastvisplane->lightlevel = pl->lightlevel;
@@ -364,18 +453,17 @@ void R_DrawPlanes (void)
     int			x;
     int			stop;
     int			angle;
-    int                 lumpnum;
 				
 #ifdef RANGECHECK
-    if (ds_p - drawsegs > MAXDRAWSEGS)
+    if (ds_p - drawsegs > drawsegpool.size)
 	I_Error ("R_DrawPlanes: drawsegs overflow (%i)",
 		 ds_p - drawsegs);
     
-    if (lastvisplane - visplanes > MAXVISPLANES)
+    if (lastvisplane - visplanes > visplanepool.size)
 	I_Error ("R_DrawPlanes: visplane overflow (%i)",
 		 lastvisplane - visplanes);
     
-    if (lastopening - openings > MAXOPENINGS)
+    if (lastopening - openings > openingpool.size)
 	I_Error ("R_DrawPlanes: opening overflow (%i)",
 		 lastopening - openings);
 #endif
@@ -389,7 +477,7 @@ void R_DrawPlanes (void)
 	// sky flat
 	if (pl->picnum == skyflatnum)
 	{
-	    dc_iscale = pspriteiscale>>detailshift;
+	    dc_iscale = PIXELASPECTINV(pspriteiscale)>>detailshift;
 	    
 	    // Sky is allways drawn full bright,
 	    //  i.e. colormaps[0] is used.
@@ -414,8 +502,7 @@ void R_DrawPlanes (void)
 	}
 	
 	// regular flat
-        lumpnum = firstflat + flattranslation[pl->picnum];
-	ds_source = W_CacheLumpNum(lumpnum, PU_STATIC);
+	ds_source = R_GetFlat(flattranslation[pl->picnum]);
 	
 	planeheight = abs(pl->height-viewz);
 	light = (pl->lightlevel >> LIGHTSEGSHIFT)+extralight;
@@ -440,7 +527,5 @@ void R_DrawPlanes (void)
 			pl->top[x],
 			pl->bottom[x]);
 	}
-	
-        W_ReleaseLumpNum(lumpnum);
     }
 }
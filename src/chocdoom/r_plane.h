@@ -26,8 +26,21 @@
 
 
 // Visplane related.
+
+// upper limit for the number of visplanes estimated from the map,
+// half of vanilla's MAXVISPLANES to save RAM
+#define MAXVISPLANES	64
+
+extern  short*		openings;
 extern  short*		lastopening;
 
+extern  visplane_t*	visplanes;
+extern  visplane_t*	lastvisplane;
+extern  boolean		visplanelinear;
+
+extern  rpool_t		visplanepool;
+extern  rpool_t		openingpool;
+
 
 typedef void (*planefunction_t) (int top, int bottom);
 
@@ -59,6 +72,8 @@ R_MakeSpans
 
 void R_DrawPlanes (void);
 
+short* R_NewOpenings (int count);
+
 visplane_t*
 R_FindPlane
 ( fixed_t	height,
@@ -108,15 +108,15 @@ R_RenderMaskedSegRange
     //   for horizontal / vertical / diagonal. Diagonal?
     // OPTIMIZE: get rid of LIGHTSEGSHIFT globally
     curline = ds->curline;
-    frontsector = curline->sidedef->sector;
-    backsector = curline->backsector;
-    texnum = texturetranslation[curline->sidedef->midtexture];
+    frontsector = SEG_FRONTSECTOR(curline);
+    backsector = SEG_BACKSECTOR(curline);
+    texnum = texturetranslation[SEG_SIDEDEF(curline)->midtexture];
 	
     lightnum = (frontsector->lightlevel >> LIGHTSEGSHIFT)+extralight;
 
-    if (curline->v1->y == curline->v2->y)
+    if (SEG_V1(curline)->y == SEG_V2(curline)->y)
 	lightnum--;
-    else if (curline->v1->x == curline->v2->x)
+    else if (SEG_V1(curline)->x == SEG_V2(curline)->x)
 	lightnum++;
 
     if (lightnum < 0)		
@@ -134,7 +134,7 @@ R_RenderMaskedSegRange
     mceilingclip = ds->sprtopclip;
     
     // find positioning
-    if (curline->linedef->flags & ML_DONTPEGBOTTOM)
+    if (SEG_LINEDEF(curline)->flags & ML_DONTPEGBOTTOM)
     {
 	dc_texturemid = frontsector->floorheight > backsector->floorheight
 	    ? frontsector->floorheight : backsector->floorheight;
@@ -146,7 +146,7 @@ R_RenderMaskedSegRange
 	    ? frontsector->ceilingheight : backsector->ceilingheight;
 	dc_texturemid = dc_texturemid - viewz;
     }
-    dc_texturemid += curline->sidedef->rowoffset;
+    dc_texturemid += SEG_SIDEDEF(curline)->rowoffset;
 			
     if (fixedcolormap)
 	dc_colormap = fixedcolormap;
@@ -159,7 +159,7 @@ R_RenderMaskedSegRange
 	{
 	    if (!fixedcolormap)
 	    {
-		index = spryscale>>LIGHTSCALESHIFT;
+		index = PIXELASPECTINV(spryscale)>>LIGHTSCALESHIFT;
 
 		if (index >=  MAXLIGHTSCALE )
 		    index = MAXLIGHTSCALE-1;
@@ -257,7 +257,7 @@ void R_RenderSegLoop (void)
 	    texturecolumn = rw_offset-FixedMul(finetangent[angle],rw_distance);
 	    texturecolumn >>= FRACBITS;
 	    // calculate lighting
-	    index = rw_scale>>LIGHTSCALESHIFT;
+	    index = PIXELASPECTINV(rw_scale)>>LIGHTSCALESHIFT;
 
 	    if (index >=  MAXLIGHTSCALE )
 		index = MAXLIGHTSCALE-1;
@@ -378,18 +378,22 @@ R_StoreWallRange
     angle_t		distangle, offsetangle;
     fixed_t		vtop;
     int			lightnum;
+    short*		clip;
 
     // don't overflow and crash
-    if (ds_p == &drawsegs[MAXDRAWSEGS])
+    if (ds_p == &drawsegs[drawsegpool.size])
+    {
+	drawsegpool.dropped++;
 	return;		
+    }
 		
 #ifdef RANGECHECK
     if (start >=viewwidth || start > stop)
 	I_Error ("Bad R_RenderWallRange: %i to %i", start , stop);
 #endif
     
-    sidedef = curline->sidedef;
-    linedef = curline->linedef;
+    sidedef = SEG_SIDEDEF(curline);
+    linedef = SEG_LINEDEF(curline);
 
     // mark the segment as visible for auto map
     linedef->flags |= ML_MAPPED;
@@ -402,7 +406,7 @@ R_StoreWallRange
 	offsetangle = ANG90;
 
     distangle = ANG90 - offsetangle;
-    hyp = R_PointToDist (curline->v1->x, curline->v1->y);
+    hyp = R_PointToDist (SEG_V1(curline)->x, SEG_V1(curline)->y);
     sineval = finesine[distangle>>ANGLETOFINESHIFT];
     rw_distance = FixedMul (hyp, sineval);
 		
@@ -431,8 +435,8 @@ R_StoreWallRange
 	    fixed_t		trx,try;
 	    fixed_t		gxt,gyt;
 
-	    trx = curline->v1->x - viewx;
-	    try = curline->v1->y - viewy;
+	    trx = SEG_V1(curline)->x - viewx;
+	    try = SEG_V1(curline)->y - viewy;
 			
 	    gxt = FixedMul(trx,viewcos); 
 	    gyt = -FixedMul(try,viewsin); 
@@ -603,10 +607,14 @@ R_StoreWallRange
 	// allocate space for masked texture tables
 	if (sidedef->midtexture)
 	{
-	    // masked midtexture
-	    maskedtexture = true;
-	    ds_p->maskedtexturecol = maskedtexturecol = lastopening - rw_x;
-	    lastopening += rw_stopx - rw_x;
+	    short *cols = R_NewOpenings (rw_stopx - rw_x);
+
+	    // masked midtexture, dropped if out of openings
+	    if (cols)
+	    {
+		maskedtexture = true;
+		ds_p->maskedtexturecol = maskedtexturecol = cols - rw_x;
+	    }
 	}
     }
     
@@ -640,9 +648,9 @@ R_StoreWallRange
 	{
 	    lightnum = (frontsector->lightlevel >> LIGHTSEGSHIFT)+extralight;
 
-	    if (curline->v1->y == curline->v2->y)
+	    if (SEG_V1(curline)->y == SEG_V2(curline)->y)
 		lightnum--;
-	    else if (curline->v1->x == curline->v2->x)
+	    else if (SEG_V1(curline)->x == SEG_V2(curline)->x)
 		lightnum++;
 
 	    if (lightnum < 0)		
@@ -712,20 +720,42 @@ R_StoreWallRange
 
     
     // save sprite clipping info
+    // if out of openings, sprites aren't clipped against this and
+    // the masked texture isn't drawn
     if ( ((ds_p->silhouette & SIL_TOP) || maskedtexture)
 	 && !ds_p->sprtopclip)
     {
-	memcpy (lastopening, ceilingclip+start, 2*(rw_stopx-start));
-	ds_p->sprtopclip = lastopening - start;
-	lastopening += rw_stopx - start;
+	clip = R_NewOpenings (rw_stopx - start);
+
+	if (clip)
+	{
+	    memcpy (clip, ceilingclip+start, 2*(rw_stopx-start));
+	    ds_p->sprtopclip = clip - start;
+	}
+	else
+	{
+	    ds_p->silhouette &= ~SIL_TOP;
+	    ds_p->maskedtexturecol = NULL;
+	    maskedtexture = false;
+	}
     }
     
     if ( ((ds_p->silhouette & SIL_BOTTOM) || maskedtexture)
 	 && !ds_p->sprbottomclip)
     {
-	memcpy (lastopening, floorclip+start, 2*(rw_stopx-start));
-	ds_p->sprbottomclip = lastopening - start;
-	lastopening += rw_stopx - start;	
+	clip = R_NewOpenings (rw_stopx - start);
+
+	if (clip)
+	{
+	    memcpy (clip, floorclip+start, 2*(rw_stopx-start));
+	    ds_p->sprbottomclip = clip - start;
+	}
+	else
+	{
+	    ds_p->silhouette &= ~SIL_BOTTOM;
+	    ds_p->maskedtexturecol = NULL;
+	    maskedtexture = false;
+	}
     }
 
     if (maskedtexture && !(ds_p->silhouette&SIL_TOP))
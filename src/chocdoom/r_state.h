@@ -49,6 +49,9 @@ extern int		viewwidth;
 extern int		scaledviewwidth;
 extern int		viewheight;
 
+extern int		stripstart;
+extern int		stripend;
+
 extern int		firstflat;
 
 // for global animation
@@ -283,8 +283,9 @@ void R_InitSpriteDefs (char** namelist)
 //
 // GAME FUNCTIONS
 //
-vissprite_t	vissprites[MAXVISSPRITES];
+vissprite_t*	vissprites;
 vissprite_t*	vissprite_p;
+rpool_t		vissprpool = {"vissprites", sizeof(vissprite_t), MEM_FAST};
 int		newvissprite;
 
 
@@ -313,6 +314,8 @@ void R_InitSprites (char** namelist)
 //
 void R_ClearSprites (void)
 {
+    R_CheckPool (&vissprpool, (void **)&vissprites);
+
     vissprite_p = vissprites;
 }
 
@@ -324,8 +327,11 @@ vissprite_t	overflowsprite;
 
 vissprite_t* R_NewVisSprite (void)
 {
-    if (vissprite_p == &vissprites[MAXVISSPRITES])
+    if (vissprite_p == &vissprites[vissprpool.size])
+    {
+	vissprpool.dropped++;
 	return &overflowsprite;
+    }
     
     vissprite_p++;
     return vissprite_p-1;
@@ -418,7 +424,7 @@ R_DrawVisSprite
 	    ( (vis->mobjflags & MF_TRANSLATION) >> (MF_TRANSSHIFT-8) );
     }
 	
-    dc_iscale = abs(vis->xiscale)>>detailshift;
+    dc_iscale = PIXELASPECTINV(abs(vis->xiscale))>>detailshift;
     dc_texturemid = vis->texturemid;
     frac = vis->startfrac;
     spryscale = vis->scale;
@@ -533,27 +539,27 @@ void R_ProjectSprite (mobj_t* thing)
     x1 = (centerxfrac + FixedMul (tx,xscale) ) >>FRACBITS;
 
     // off the right side?
-    if (x1 > viewwidth)
+    if (x1 > stripend)
 	return;
     
     tx +=  spritewidth[lump];
     x2 = ((centerxfrac + FixedMul (tx,xscale) ) >>FRACBITS) - 1;
 
     // off the left side
-    if (x2 < 0)
+    if (x2 < stripstart)
 	return;
     
     // store information in a vissprite
     vis = R_NewVisSprite ();
     vis->mobjflags = thing->flags;
-    vis->scale = xscale<<detailshift;
+    vis->scale = PIXELASPECT(xscale)<<detailshift;
     vis->gx = thing->x;
     vis->gy = thing->y;
     vis->gz = thing->z;
     vis->gzt = thing->z + spritetopoffset[lump];
     vis->texturemid = vis->gzt - viewz;
-    vis->x1 = x1 < 0 ? 0 : x1;
-    vis->x2 = x2 >= viewwidth ? viewwidth-1 : x2;	
+    vis->x1 = x1 < stripstart ? stripstart : x1;
+    vis->x2 = x2 >= stripend ? stripend-1 : x2;	
     iscale = FixedDiv (FRACUNIT, xscale);
 
     if (flip)
@@ -676,23 +682,23 @@ void R_DrawPSprite (pspdef_t* psp)
     x1 = (centerxfrac + FixedMul (tx,pspritescale) ) >>FRACBITS;
 
     // off the right side
-    if (x1 > viewwidth)
+    if (x1 > stripend)
 	return;		
 
     tx +=  spritewidth[lump];
     x2 = ((centerxfrac + FixedMul (tx, pspritescale) ) >>FRACBITS) - 1;
 
     // off the left side
-    if (x2 < 0)
+    if (x2 < stripstart)
 	return;
     
     // store information in a vissprite
     vis = &avis;
     vis->mobjflags = 0;
     vis->texturemid = (BASEYCENTER<<FRACBITS)+FRACUNIT/2-(psp->sy-spritetopoffset[lump]);
-    vis->x1 = x1 < 0 ? 0 : x1;
-    vis->x2 = x2 >= viewwidth ? viewwidth-1 : x2;	
-    vis->scale = pspritescale<<detailshift;
+    vis->x1 = x1 < stripstart ? stripstart : x1;
+    vis->x2 = x2 >= stripend ? stripend-1 : x2;	
+    vis->scale = PIXELASPECT(pspritescale)<<detailshift;
     
     if (flip)
     {
@@ -781,73 +787,240 @@ void R_DrawPlayerSprites (void)
 vissprite_t	vsprsortedhead;
 
 
+//
+// SortVisSpriteRange
+// Stable merge sort of vissprites[first .. first+count-1] by scale,
+// returns a NULL terminated list linked through next. Equal scales
+// keep their order, which is what the selection sort in vanilla did.
+//
+static vissprite_t* SortVisSpriteRange (int first, int count)
+{
+    vissprite_t*	a;
+    vissprite_t*	b;
+    vissprite_t*	head;
+    vissprite_t**	tail;
+    int			half;
+
+    if (count == 1)
+    {
+	vissprites[first].next = NULL;
+	return &vissprites[first];
+    }
+
+    half = count / 2;
+    a = SortVisSpriteRange (first, half);
+    b = SortVisSpriteRange (first + half, count - half);
+
+    tail = &head;
+
+    while (a && b)
+    {
+	// take from the earlier half on ties
+	if (b->scale < a->scale)
+	{
+	    *tail = b;
+	    b = b->next;
+	}
+	else
+	{
+	    *tail = a;
+	    a = a->next;
+	}
+
+	tail = &(*tail)->next;
+    }
+
+    *tail = a ? a : b;
+
+    return head;
+}
+
+
 void R_SortVisSprites (void)
 {
-    int			i;
     int			count;
     vissprite_t*	ds;
-    vissprite_t*	best;
-    vissprite_t		unsorted;
-    fixed_t		bestscale;
+    vissprite_t*	prev;
 
     count = vissprite_p - vissprites;
 	
-    unsorted.next = unsorted.prev = &unsorted;
+    vsprsortedhead.next = vsprsortedhead.prev = &vsprsortedhead;
 
     if (!count)
 	return;
-		
-    for (ds=vissprites ; ds<vissprite_p ; ds++)
+
+    // farthest (smallest scale) first
+    prev = &vsprsortedhead;
+
+    for (ds = SortVisSpriteRange (0, count) ; ds ; ds = ds->next)
     {
-	ds->next = ds+1;
-	ds->prev = ds-1;
+	ds->prev = prev;
+	prev->next = ds;
+	prev = ds;
     }
-    
-    vissprites[0].prev = &unsorted;
-    unsorted.next = &vissprites[0];
-    (vissprite_p-1)->next = &unsorted;
-    unsorted.prev = vissprite_p-1;
-    
-    // pull the vissprites out by scale
 
-    vsprsortedhead.next = vsprsortedhead.prev = &vsprsortedhead;
-    for (i=0 ; i<count ; i++)
+    prev->next = &vsprsortedhead;
+    vsprsortedhead.prev = prev;
+}
+
+
+
+//
+// DRAWSEG BUCKETS
+// The drawsegs that can clip a sprite (with a silhouette or masked
+// texture), newest first, for each DSBUCKETWIDTH column wide strip of
+// the screen. Built once per frame so that R_DrawSprite only looks at
+// drawsegs near the sprite. A strip that has too many drawsegs falls
+// back to scanning all of them.
+//
+#define DSBUCKETSHIFT	5
+#define NUMDSBUCKETS	((SCREENWIDTH >> DSBUCKETSHIFT) + 1)
+#define DSBUCKETSIZE	64
+
+static short		dsbuckets[NUMDSBUCKETS][DSBUCKETSIZE];
+static int		dsbucketcount[NUMDSBUCKETS];
+
+// walk every drawseg for each sprite instead, for doom-benchmark to compare
+boolean			drawseglinear = false;
+
+// clip without drawing the masked segs behind the sprite
+static boolean		clipsonly = false;
+
+static void R_BuildDrawSegBuckets (void)
+{
+    drawseg_t*		ds;
+    int			b;
+
+    memset (dsbucketcount, 0, sizeof(dsbucketcount));
+
+    for (ds=ds_p-1 ; ds >= drawsegs ; ds--)
     {
-	bestscale = INT_MAX;
-        best = unsorted.next;
-	for (ds=unsorted.next ; ds!= &unsorted ; ds=ds->next)
+	if (!ds->silhouette && !ds->maskedtexturecol)
+	    continue;
+
+	for (b = ds->x1 >> DSBUCKETSHIFT ; b <= ds->x2 >> DSBUCKETSHIFT ; b++)
 	{
-	    if (ds->scale < bestscale)
-	    {
-		bestscale = ds->scale;
-		best = ds;
-	    }
+	    if (dsbucketcount[b] < DSBUCKETSIZE)
+		dsbuckets[b][dsbucketcount[b]] = ds - drawsegs;
+
+	    dsbucketcount[b]++;
 	}
-	best->next->prev = best->prev;
-	best->prev->next = best->next;
-	best->next = &vsprsortedhead;
-	best->prev = vsprsortedhead.prev;
-	vsprsortedhead.prev->next = best;
-	vsprsortedhead.prev = best;
     }
 }
 
 
-
 //
-// R_DrawSprite
+// R_ClipSpriteSeg
+// Clips the sprite against one drawseg, or draws the drawseg's masked
+// texture if it is behind the sprite.
 //
-void R_DrawSprite (vissprite_t* spr)
+static void
+R_ClipSpriteSeg
+( vissprite_t*	spr,
+  drawseg_t*	ds,
+  short*	clipbot,
+  short*	cliptop )
 {
-    drawseg_t*		ds;
-    short		clipbot[SCREENWIDTH];
-    short		cliptop[SCREENWIDTH];
     int			x;
     int			r1;
     int			r2;
     fixed_t		scale;
     fixed_t		lowscale;
     int			silhouette;
+
+    // determine if the drawseg obscures the sprite
+    if (ds->x1 > spr->x2
+	|| ds->x2 < spr->x1
+	|| (!ds->silhouette
+	    && !ds->maskedtexturecol) )
+    {
+	// does not cover sprite
+	return;
+    }
+		
+    r1 = ds->x1 < spr->x1 ? spr->x1 : ds->x1;
+    r2 = ds->x2 > spr->x2 ? spr->x2 : ds->x2;
+
+    if (ds->scale1 > ds->scale2)
+    {
+	lowscale = ds->scale2;
+	scale = ds->scale1;
+    }
+    else
+    {
+	lowscale = ds->scale1;
+	scale = ds->scale2;
+    }
+	
+    if (scale < spr->scale
+	|| ( lowscale < spr->scale
+	     && !R_PointOnSegSide (spr->gx, spr->gy, ds->curline) ) )
+    {
+	// masked mid texture?
+	if (ds->maskedtexturecol && !clipsonly)
+	    R_RenderMaskedSegRange (ds, r1, r2);
+	// seg is behind sprite
+	return;			
+    }
+
+    
+    // clip this piece of the sprite
+    silhouette = ds->silhouette;
+    
+    if (spr->gz >= ds->bsilheight)
+	silhouette &= ~SIL_BOTTOM;
+
+    if (spr->gzt <= ds->tsilheight)
+	silhouette &= ~SIL_TOP;
+		
+    if (silhouette == 1)
+    {
+	// bottom sil
+	for (x=r1 ; x<=r2 ; x++)
+	    if (clipbot[x] == -2)
+		clipbot[x] = ds->sprbottomclip[x];
+    }
+    else if (silhouette == 2)
+    {
+	// top sil
+	for (x=r1 ; x<=r2 ; x++)
+	    if (cliptop[x] == -2)
+		cliptop[x] = ds->sprtopclip[x];
+    }
+    else if (silhouette == 3)
+    {
+	// both
+	for (x=r1 ; x<=r2 ; x++)
+	{
+	    if (clipbot[x] == -2)
+		clipbot[x] = ds->sprbottomclip[x];
+	    if (cliptop[x] == -2)
+		cliptop[x] = ds->sprtopclip[x];
+	}
+    }
+}
+
+
+//
+// R_ClipSprite
+// Fills in clipbot/cliptop for the sprite's columns from the drawsegs
+// that obscure it, -2 where none do. Walks every drawseg if fullwalk is
+// set, otherwise only those in the buckets the sprite covers.
+//
+static void
+R_ClipSprite
+( vissprite_t*	spr,
+  short*	clipbot,
+  short*	cliptop,
+  boolean	fullwalk )
+{
+    drawseg_t*		ds;
+    int			pos[NUMDSBUCKETS];
+    int			x;
+    int			b;
+    int			b1;
+    int			b2;
+    int			best;
 		
     for (x = spr->x1 ; x<=spr->x2 ; x++)
 	clipbot[x] = cliptop[x] = -2;
@@ -855,80 +1028,104 @@ void R_DrawSprite (vissprite_t* spr)
     // Scan drawsegs from end to start for obscuring segs.
     // The first drawseg that has a greater scale
     //  is the clip seg.
-    for (ds=ds_p-1 ; ds >= drawsegs ; ds--)
+    b1 = spr->x1 >> DSBUCKETSHIFT;
+    b2 = spr->x2 >> DSBUCKETSHIFT;
+
+    for (b = b1 ; b <= b2 ; b++)
     {
-	// determine if the drawseg obscures the sprite
-	if (ds->x1 > spr->x2
-	    || ds->x2 < spr->x1
-	    || (!ds->silhouette
-		&& !ds->maskedtexturecol) )
-	{
-	    // does not cover sprite
-	    continue;
-	}
-			
-	r1 = ds->x1 < spr->x1 ? spr->x1 : ds->x1;
-	r2 = ds->x2 > spr->x2 ? spr->x2 : ds->x2;
+	pos[b] = 0;
 
-	if (ds->scale1 > ds->scale2)
-	{
-	    lowscale = ds->scale2;
-	    scale = ds->scale1;
-	}
-	else
-	{
-	    lowscale = ds->scale1;
-	    scale = ds->scale2;
-	}
-		
-	if (scale < spr->scale
-	    || ( lowscale < spr->scale
-		 && !R_PointOnSegSide (spr->gx, spr->gy, ds->curline) ) )
+	if (dsbucketcount[b] > DSBUCKETSIZE)
+	    fullwalk = true;
+    }
+
+    if (fullwalk)
+    {
+	for (ds=ds_p-1 ; ds >= drawsegs ; ds--)
+	    R_ClipSpriteSeg (spr, ds, clipbot, cliptop);
+    }
+    else
+    {
+	// merge the buckets the sprite covers, a drawseg that spans
+	// several of them is at the head of each at the same time
+	for (;;)
 	{
-	    // masked mid texture?
-	    if (ds->maskedtexturecol)	
-		R_RenderMaskedSegRange (ds, r1, r2);
-	    // seg is behind sprite
-	    continue;			
-	}
+	    best = -1;
 
-	
-	// clip this piece of the sprite
-	silhouette = ds->silhouette;
-	
-	if (spr->gz >= ds->bsilheight)
-	    silhouette &= ~SIL_BOTTOM;
+	    for (b = b1 ; b <= b2 ; b++)
+	    {
+		if (pos[b] < dsbucketcount[b] && dsbuckets[b][pos[b]] > best)
+		    best = dsbuckets[b][pos[b]];
+	    }
 
-	if (spr->gzt <= ds->tsilheight)
-	    silhouette &= ~SIL_TOP;
-			
-	if (silhouette == 1)
-	{
-	    // bottom sil
-	    for (x=r1 ; x<=r2 ; x++)
-		if (clipbot[x] == -2)
-		    clipbot[x] = ds->sprbottomclip[x];
-	}
-	else if (silhouette == 2)
-	{
-	    // top sil
-	    for (x=r1 ; x<=r2 ; x++)
-		if (cliptop[x] == -2)
-		    cliptop[x] = ds->sprtopclip[x];
+	    if (best < 0)
+		break;
+
+	    for (b = b1 ; b <= b2 ; b++)
+	    {
+		if (pos[b] < dsbucketcount[b] && dsbuckets[b][pos[b]] == best)
+		    pos[b]++;
+	    }
+
+	    R_ClipSpriteSeg (spr, drawsegs + best, clipbot, cliptop);
 	}
-	else if (silhouette == 3)
+    }
+}
+
+
+//
+// R_CheckSpriteClips
+// Clips every vissprite of the last frame (drawn with the buckets)
+// through the buckets and through the full walk, without drawing any
+// masked segs, and returns how many sprites came out differently.
+//
+int R_CheckSpriteClips (void)
+{
+    static short	clipbot[2][SCREENWIDTH];
+    static short	cliptop[2][SCREENWIDTH];
+    vissprite_t*	spr;
+    int			x;
+    int			mismatches;
+
+    // the buckets are only built for a frame with sprites
+    if (vissprite_p == vissprites)
+	return 0;
+
+    mismatches = 0;
+    clipsonly = true;
+
+    for (spr = vissprites ; spr < vissprite_p ; spr++)
+    {
+	R_ClipSprite (spr, clipbot[0], cliptop[0], false);
+	R_ClipSprite (spr, clipbot[1], cliptop[1], true);
+
+	for (x = spr->x1 ; x<=spr->x2 ; x++)
 	{
-	    // both
-	    for (x=r1 ; x<=r2 ; x++)
+	    if (clipbot[0][x] != clipbot[1][x]
+		|| cliptop[0][x] != cliptop[1][x])
 	    {
-		if (clipbot[x] == -2)
-		    clipbot[x] = ds->sprbottomclip[x];
-		if (cliptop[x] == -2)
-		    cliptop[x] = ds->sprtopclip[x];
+		mismatches++;
+		break;
 	    }
 	}
-		
     }
+
+    clipsonly = false;
+
+    return mismatches;
+}
+
+
+//
+// R_DrawSprite
+//
+void R_DrawSprite (vissprite_t* spr)
+{
+    short		clipbot[SCREENWIDTH];
+    short		cliptop[SCREENWIDTH];
+    int			x;
+
+    R_ClipSprite (spr, clipbot, cliptop, drawseglinear);
     
     // all clipping has been performed, so draw the sprite
 
@@ -962,6 +1159,9 @@ void R_DrawMasked (void)
 
     if (vissprite_p > vissprites)
     {
+	if (!drawseglinear)
+	    R_BuildDrawSegBuckets ();
+
 	// draw all vissprites back to front
 	for (spr = vsprsortedhead.next ;
 	     spr != &vsprsortedhead ;
@@ -22,11 +22,14 @@
 
 
 
+// upper limit for the size estimated from the map
 #define MAXVISSPRITES  	128
 
-extern vissprite_t	vissprites[MAXVISSPRITES];
+extern vissprite_t*	vissprites;
 extern vissprite_t*	vissprite_p;
+extern rpool_t		vissprpool;
 extern vissprite_t	vsprsortedhead;
+extern boolean		drawseglinear;
 
 // Constant arrays used for psprite clipping
 //  and initializing clipping.
@@ -54,6 +57,7 @@ void R_DrawSprites (void);
 void R_InitSprites (char** namelist);
 void R_ClearSprites (void);
 void R_DrawMasked (void);
+int R_CheckSpriteClips (void);
 
 void
 R_ClipVisSprite
@@ -84,7 +84,7 @@
 #define ST_X2				104
 
 #define ST_FX  			143
-#define ST_FY  			169
+#define ST_FY  			(ST_Y + 1)
 
 // Should be set to patch width
 //  for tall numbers later on
@@ -112,7 +112,7 @@
 #define ST_DEADFACE			(ST_GODFACE+1)
 
 #define ST_FACESX			143
-#define ST_FACESY			168
+#define ST_FACESY			ST_Y
 
 #define ST_EVILGRINCOUNT		(2*TICRATE)
 #define ST_STRAIGHTFACECOUNT	(TICRATE/2)
@@ -134,105 +134,105 @@
 // AMMO number pos.
 #define ST_AMMOWIDTH		3	
 #define ST_AMMOX			44
-#define ST_AMMOY			171
+#define ST_AMMOY			(ST_Y + 3)
 
 // HEALTH number pos.
 #define ST_HEALTHWIDTH		3	
 #define ST_HEALTHX			90
-#define ST_HEALTHY			171
+#define ST_HEALTHY			(ST_Y + 3)
 
 // Weapon pos.
 #define ST_ARMSX			111
-#define ST_ARMSY			172
+#define ST_ARMSY			(ST_Y + 4)
 #define ST_ARMSBGX			104
-#define ST_ARMSBGY			168
+#define ST_ARMSBGY			ST_Y
 #define ST_ARMSXSPACE		12
 #define ST_ARMSYSPACE		10
 
 // Frags pos.
 #define ST_FRAGSX			138
-#define ST_FRAGSY			171	
+#define ST_FRAGSY			(ST_Y + 3)	
 #define ST_FRAGSWIDTH		2
 
 // ARMOR number pos.
 #define ST_ARMORWIDTH		3
 #define ST_ARMORX			221
-#define ST_ARMORY			171
+#define ST_ARMORY			(ST_Y + 3)
 
 // Key icon positions.
 #define ST_KEY0WIDTH		8
 #define ST_KEY0HEIGHT		5
 #define ST_KEY0X			239
-#define ST_KEY0Y			171
+#define ST_KEY0Y			(ST_Y + 3)
 #define ST_KEY1WIDTH		ST_KEY0WIDTH
 #define ST_KEY1X			239
-#define ST_KEY1Y			181
+#define ST_KEY1Y			(ST_Y + 13)
 #define ST_KEY2WIDTH		ST_KEY0WIDTH
 #define ST_KEY2X			239
-#define ST_KEY2Y			191
+#define ST_KEY2Y			(ST_Y + 23)
 
 // Ammunition counter.
 #define ST_AMMO0WIDTH		3
 #define ST_AMMO0HEIGHT		6
 #define ST_AMMO0X			288
-#define ST_AMMO0Y			173
+#define ST_AMMO0Y			(ST_Y + 5)
 #define ST_AMMO1WIDTH		ST_AMMO0WIDTH
 #define ST_AMMO1X			288
-#define ST_AMMO1Y			179
+#define ST_AMMO1Y			(ST_Y + 11)
 #define ST_AMMO2WIDTH		ST_AMMO0WIDTH
 #define ST_AMMO2X			288
-#define ST_AMMO2Y			191
+#define ST_AMMO2Y			(ST_Y + 23)
 #define ST_AMMO3WIDTH		ST_AMMO0WIDTH
 #define ST_AMMO3X			288
-#define ST_AMMO3Y			185
+#define ST_AMMO3Y			(ST_Y + 17)
 
 // Indicate maximum ammunition.
 // Only needed because backpack exists.
 #define ST_MAXAMMO0WIDTH		3
 #define ST_MAXAMMO0HEIGHT		5
 #define ST_MAXAMMO0X		314
-#define ST_MAXAMMO0Y		173
+#define ST_MAXAMMO0Y		(ST_Y + 5)
 #define ST_MAXAMMO1WIDTH		ST_MAXAMMO0WIDTH
 #define ST_MAXAMMO1X		314
-#define ST_MAXAMMO1Y		179
+#define ST_MAXAMMO1Y		(ST_Y + 11)
 #define ST_MAXAMMO2WIDTH		ST_MAXAMMO0WIDTH
 #define ST_MAXAMMO2X		314
-#define ST_MAXAMMO2Y		191
+#define ST_MAXAMMO2Y		(ST_Y + 23)
 #define ST_MAXAMMO3WIDTH		ST_MAXAMMO0WIDTH
 #define ST_MAXAMMO3X		314
-#define ST_MAXAMMO3Y		185
+#define ST_MAXAMMO3Y		(ST_Y + 17)
 
 // pistol
 #define ST_WEAPON0X			110 
-#define ST_WEAPON0Y			172
+#define ST_WEAPON0Y			(ST_Y + 4)
 
 // shotgun
 #define ST_WEAPON1X			122 
-#define ST_WEAPON1Y			172
+#define ST_WEAPON1Y			(ST_Y + 4)
 
 // chain gun
 #define ST_WEAPON2X			134 
-#define ST_WEAPON2Y			172
+#define ST_WEAPON2Y			(ST_Y + 4)
 
 // missile launcher
 #define ST_WEAPON3X			110 
-#define ST_WEAPON3Y			181
+#define ST_WEAPON3Y			(ST_Y + 13)
 
 // plasma gun
 #define ST_WEAPON4X			122 
-#define ST_WEAPON4Y			181
+#define ST_WEAPON4Y			(ST_Y + 13)
 
  // bfg
 #define ST_WEAPON5X			134
-#define ST_WEAPON5Y			181
+#define ST_WEAPON5Y			(ST_Y + 13)
 
 // WPNS title
 #define ST_WPNSX			109 
-#define ST_WPNSY			191
+#define ST_WPNSY			(ST_Y + 23)
 
  // DETH title
 #define ST_DETHX			109
-#define ST_DETHY			191
+#define ST_DETHY			(ST_Y + 23)
 
 //Incoming messages window location
 //UNUSED
@@ -57,8 +57,17 @@ byte *xlatab = NULL;
 
 static byte *dest_screen = NULL;
 
+// Added to the y coordinate of patches, to centre 320x200 screens
+
+static int dest_yoffset = 0;
+
 int dirtybox[4]; 
 
+// Lines of I_VideoBuffer drawn to since the last I_FinishUpdate, which
+// only needs to present these.
+
+byte dirtylines[SCREENHEIGHT];
+
 // haleyjd 08/28/10: clipping callback function for patches.
 // This is needed for Chocolate Strife, which clips patches to the screen.
 static vpatchclipfunc_t patchclip_callback = NULL;
@@ -75,8 +84,42 @@ void V_MarkRect(int x, int y, int width, int height)
     {
         M_AddToBox (dirtybox, x, y); 
         M_AddToBox (dirtybox, x + width-1, y + height-1); 
+
+        if (y < 0)
+        {
+            height += y;
+            y = 0;
+        }
+
+        if (y + height > SCREENHEIGHT)
+        {
+            height = SCREENHEIGHT - y;
+        }
+
+        if (height > 0)
+        {
+            memset(dirtylines + y, 1, height);
+        }
     }
 } 
+
+//
+// V_MarkAllDirty
+// Makes the next I_FinishUpdate present the whole screen.
+//
+void V_MarkAllDirty(void)
+{
+    memset(dirtylines, 1, SCREENHEIGHT);
+}
+
+//
+// V_ClearDirty
+// Called once the dirty lines have been presented.
+//
+void V_ClearDirty(void)
+{
+    memset(dirtylines, 0, SCREENHEIGHT);
+}
  
 
 //
@@ -147,6 +190,7 @@ void V_DrawPatch(int x, int y, patch_t *patch)
     int w;
 
     y -= SHORT(patch->topoffset);
+    y += dest_yoffset;
     x -= SHORT(patch->leftoffset);
 
     // haleyjd 08/28/10: Strife needs silent error checking here.
@@ -211,6 +255,7 @@ void V_DrawPatchFlipped(int x, int y, patch_t *patch)
     int w; 
  
     y -= SHORT(patch->topoffset); 
+    y += dest_yoffset;
     x -= SHORT(patch->leftoffset); 
 
     // haleyjd 08/28/10: Strife needs silent error checking here.
@@ -284,6 +329,7 @@ void V_DrawTLPatch(int x, int y, patch_t * patch)
     int w;
 
     y -= SHORT(patch->topoffset);
+    y += dest_yoffset;
     x -= SHORT(patch->leftoffset);
 
     if (x < 0
@@ -334,6 +380,7 @@ void V_DrawXlaPatch(int x, int y, patch_t * patch)
     int w;
 
     y -= SHORT(patch->topoffset);
+    y += dest_yoffset;
     x -= SHORT(patch->leftoffset);
 
     if(patchclip_callback)
@@ -383,6 +430,7 @@ void V_DrawAltTLPatch(int x, int y, patch_t * patch)
     int w;
 
     y -= SHORT(patch->topoffset);
+    y += dest_yoffset;
     x -= SHORT(patch->leftoffset);
 
     if (x < 0
@@ -434,6 +482,7 @@ void V_DrawShadowedPatch(int x, int y, patch_t *patch)
     int w;
 
     y -= SHORT(patch->topoffset);
+    y += dest_yoffset;
     x -= SHORT(patch->leftoffset);
 
     if (x < 0
@@ -531,6 +580,8 @@ void V_DrawFilledBox(int x, int y, int w, int h, int c)
     uint8_t *buf, *buf1;
     int x1, y1;
 
+    V_MarkRect(x, y, w, h);
+
     buf = I_VideoBuffer + SCREENWIDTH * y + x;
 
     for (y1 = 0; y1 < h; ++y1)
@@ -551,6 +602,8 @@ void V_DrawHorizLine(int x, int y, int w, int c)
     uint8_t *buf;
     int x1;
 
+    V_MarkRect(x, y, w, 1);
+
     buf = I_VideoBuffer + SCREENWIDTH * y + x;
 
     for (x1 = 0; x1 < w; ++x1)
@@ -564,6 +617,8 @@ void V_DrawVertLine(int x, int y, int h, int c)
     uint8_t *buf;
     int y1;
 
+    V_MarkRect(x, y, 1, h);
+
     buf = I_VideoBuffer + SCREENWIDTH * y + x;
 
     for (y1 = 0; y1 < h; ++y1)
@@ -588,6 +643,7 @@ void V_DrawBox(int x, int y, int w, int h, int c)
  
 void V_DrawRawScreen(byte *raw)
 {
+    V_MarkRect(0, 0, SCREENWIDTH, SCREENHEIGHT);
     memcpy(dest_screen, raw, SCREENWIDTH * SCREENHEIGHT);
 }
 
@@ -615,6 +671,13 @@ void V_RestoreBuffer(void)
     dest_screen = I_VideoBuffer;
 }
 
+// Set the offset added to the y coordinate of patches.
+
+void V_SetYOffset(int offset)
+{
+    dest_yoffset = offset;
+}
+
 //
 // SCREEN SHOTS
 //
@@ -35,6 +35,7 @@
 
 
 extern int dirtybox[4];
+extern byte dirtylines[];
 
 extern byte *tinttable;
 
@@ -67,6 +68,8 @@ void V_DrawPatchDirect(int x, int y, patch_t *patch);
 void V_DrawBlock(int x, int y, int width, int height, byte *src);
 
 void V_MarkRect(int x, int y, int width, int height);
+void V_MarkAllDirty(void);
+void V_ClearDirty(void);
 
 void V_DrawFilledBox(int x, int y, int w, int h, int c);
 void V_DrawHorizLine(int x, int y, int w, int c);
@@ -85,6 +88,11 @@ void V_UseBuffer(byte *buffer);
 
 void V_RestoreBuffer(void);
 
+// Offset patches vertically, used to centre 320x200 screens on a taller
+// one (ORIGYOFFSET).
+
+void V_SetYOffset(int offset);
+
 // Save a screenshot of the current screen to a file, named in the 
 // format described in the string passed to the function, eg.
 // "DOOM%02i.pcx"
@@ -54,9 +54,36 @@ typedef struct
 lumpinfo_t *lumpinfo;		
 unsigned int numlumps = 0;
 
-// Hash table for fast lookups
+// Lump name index for each loaded file, most recently added first.
+// The index is either mapped from a ".idx" file written by
+// append_wads.py, or generated into zone memory by W_GenerateHashTable.
 
-static lumpinfo_t **lumphash;
+typedef struct
+{
+    // Should be "LIDX".
+    char		identification[4];
+    int			numlumps;
+    int			infotableofs;
+    int			numbuckets;
+    // offset of int buckets[numbuckets], int next[numlumps]
+    // (padded so that they are aligned)
+    int			tableofs;
+} PACKEDATTR lumpindexheader_t;
+
+typedef struct wadindex_s
+{
+    int startlump;
+    int numlumps;
+
+    // NULL until an index is found or generated
+    int numbuckets;
+    const int *buckets;
+    const int *next;
+
+    struct wadindex_s *prev;
+} wadindex_t;
+
+static wadindex_t *wadindexes = NULL;
 
 // Hash function used for lump names.
 
@@ -76,6 +103,57 @@ unsigned int W_LumpNameHash(const char *s)
     return result;
 }
 
+// Map the lump name index written alongside a WAD by append_wads.py.
+// Returns false if there is no index or it doesn't match the WAD.
+static boolean LoadLumpIndex(char *filename, wadinfo_t *header,
+                             wadindex_t *index)
+{
+    char *idxname;
+    wad_file_t *idx_file;
+    lumpindexheader_t *idx_header;
+    int numbuckets;
+    int tableofs;
+
+    idxname = M_StringJoin(filename, ".idx", NULL);
+    idx_file = W_OpenFile(idxname);
+    free(idxname);
+
+    if (idx_file == NULL)
+    {
+        return false;
+    }
+
+    // only useful if we can use it in place
+    if (idx_file->mapped == NULL || idx_file->length < sizeof(lumpindexheader_t))
+    {
+        W_CloseFile(idx_file);
+        return false;
+    }
+
+    idx_header = (lumpindexheader_t *)idx_file->mapped;
+    numbuckets = LONG(idx_header->numbuckets);
+    tableofs = LONG(idx_header->tableofs);
+
+    if (strncmp(idx_header->identification, "LIDX", 4)
+     || LONG(idx_header->numlumps) != header->numlumps
+     || LONG(idx_header->infotableofs) != header->infotableofs
+     || numbuckets <= 0
+     || tableofs < (int)sizeof(lumpindexheader_t)
+     || idx_file->length < tableofs + (numbuckets + header->numlumps) * sizeof(int))
+    {
+        printf(" ignoring stale lump index %s.idx\n", filename);
+        W_CloseFile(idx_file);
+        return false;
+    }
+
+    // the file stays open, the index is used directly from the mapping
+    index->numbuckets = numbuckets;
+    index->buckets = (const int *)(idx_file->mapped + tableofs);
+    index->next = index->buckets + numbuckets;
+
+    return true;
+}
+
 // Increase the size of the lumpinfo[] array to the specified size.
 static void ExtendLumpInfo(int newnumlumps)
 {
@@ -140,6 +218,7 @@ wad_file_t *W_AddFile (char *filename)
     filelump_t *fileinfo;
     filelump_t *filerover;
     int newnumlumps;
+    wadindex_t *index;
 
     // open the file and add to directory
 
@@ -153,6 +232,11 @@ wad_file_t *W_AddFile (char *filename)
 
     newnumlumps = numlumps;
 
+    index = Z_Malloc(sizeof(wadindex_t), PU_STATIC, 0);
+    index->numbuckets = 0;
+    index->buckets = NULL;
+    index->next = NULL;
+
     if (strcasecmp(filename+strlen(filename)-3 , "wad" ) )
     {
     	// single lump file
@@ -197,6 +281,8 @@ wad_file_t *W_AddFile (char *filename)
         //W_Read(wad_file, header.infotableofs, fileinfo, length);
         fileinfo = (filelump_t *)(wad_file->mapped + header.infotableofs);
         newnumlumps += header.numlumps;
+
+        LoadLumpIndex(filename, &header, index);
     }
 
     // Increase size of numlumps array to accomodate the new file.
@@ -222,11 +308,10 @@ wad_file_t *W_AddFile (char *filename)
 
     //Z_Free(fileinfo);
 
-    if (lumphash != NULL)
-    {
-        Z_Free(lumphash);
-        lumphash = NULL;
-    }
+    index->startlump = startlump;
+    index->numlumps = numlumps - startlump;
+    index->prev = wadindexes;
+    wadindexes = index;
 
     return wad_file;
 }
@@ -250,38 +335,38 @@ int W_NumLumps (void)
 
 int W_CheckNumForName (char* name)
 {
-    lumpinfo_t *lump_p;
+    wadindex_t *index;
+    unsigned int hash;
     int i;
 
-    // Do we have a hash table yet?
+    hash = W_LumpNameHash(name);
 
-    /*if (lumphash != NULL)
-    {
-        int hash;
-        
-        // We do! Excellent.
+    // scan files backwards so patch lump files take precedence
 
-        hash = W_LumpNameHash(name) % numlumps;
-        
-        for (lump_p = lumphash[hash]; lump_p != NULL; lump_p = lump_p->next)
+    for (index = wadindexes; index != NULL; index = index->prev)
+    {
+        if (index->buckets != NULL)
         {
-            if (!strncasecmp(lump_p->name, name, 8))
+            // chains are in descending lump order, same as the linear scan
+            for (i = LONG(index->buckets[hash % index->numbuckets]);
+                 i >= 0; i = LONG(index->next[i]))
             {
-                return lump_p - lumpinfo;
+                if (!strncasecmp(lumpinfo[index->startlump + i].ptr->name, name, 8))
+                {
+                    return index->startlump + i;
+                }
             }
         }
-    } 
-    else*/
-    {
-        // We don't have a hash table generate yet. Linear search :-(
-        // 
-        // scan backwards so patch lump files take precedence
-
-        for (i=numlumps-1; i >= 0; --i)
+        else
         {
-            if (!strncasecmp(lumpinfo[i].ptr->name, name, 8))
+            // No index for this file (yet). Linear search :-(
+
+            for (i = index->numlumps - 1; i >= 0; --i)
             {
-                return i;
+                if (!strncasecmp(lumpinfo[index->startlump + i].ptr->name, name, 8))
+                {
+                    return index->startlump + i;
+                }
             }
         }
     }
@@ -529,37 +614,50 @@ void W_Profile (void)
 
 #endif
 
-// Generate a hash table for fast lookups
+// Generate a hash table for fast lookups, for any files that didn't
+// come with a precomputed index
 
 void W_GenerateHashTable(void)
 {
-    /*unsigned int i;
-
-    // Free the old hash table, if there is one
+    wadindex_t *index;
+    int *buckets;
+    int *next;
+    int i;
 
-    if (lumphash != NULL)
+    for (index = wadindexes; index != NULL; index = index->prev)
     {
-        Z_Free(lumphash);
-    }
+        if (index->buckets != NULL || index->numlumps == 0)
+        {
+            continue;
+        }
 
-    // Generate hash table
-    if (numlumps > 0)
-    {
-        lumphash = Z_Malloc(sizeof(lumpinfo_t *) * numlumps, PU_STATIC, NULL);
-        memset(lumphash, 0, sizeof(lumpinfo_t *) * numlumps);
+        // same layout as the .idx files from append_wads.py
+        buckets = Z_Malloc(sizeof(int) * index->numlumps * 2, PU_STATIC, NULL);
+        next = buckets + index->numlumps;
 
-        for (i=0; i<numlumps; ++i)
+        for (i = 0; i < index->numlumps; ++i)
         {
-            unsigned int hash;
+            buckets[i] = -1;
+        }
 
-            hash = W_LumpNameHash(lumpinfo[i].name) % numlumps;
+        // Hook into the hash table. Later lumps end up at the head of
+        // the chains so they take precedence.
 
-            // Hook into the hash table
+        for (i = 0; i < index->numlumps; ++i)
+        {
+            unsigned int hash;
+
+            hash = W_LumpNameHash(lumpinfo[index->startlump + i].ptr->name)
+                 % index->numlumps;
 
-            lumpinfo[i].next = lumphash[hash];
-            lumphash[hash] = &lumpinfo[i];
+            next[i] = buckets[hash];
+            buckets[hash] = i;
         }
-    }*/
+
+        index->numbuckets = index->numlumps;
+        index->buckets = buckets;
+        index->next = next;
+    }
 
     // All done!
 }
@@ -17,6 +17,8 @@
 //
 
 
+#include <string.h>
+
 #include "z_zone.h"
 #include "i_system.h"
 #include "doomtype.h"
@@ -35,16 +37,19 @@
  
 #define MEM_ALIGN sizeof(void *)
 #define ZONEID	0x1d4a1100
+#define SLABID	0x1d4a5100
 
+// idtag is always the last field of the header so that Z_Free can tell
+// zone blocks and slab objects apart by looking at the word before ptr.
 typedef struct memblock_s
 {
-    int			size;	// including the header and possibly tiny fragments
     void**		user;
+    struct memblock_s*	next;
+    struct memblock_s*	prev;
+    int			size;	// including the header and possibly tiny fragments
     //int			tag;	// PU_FREE if this is free
     //int			id;	// should be ZONEID
     int idtag;
-    struct memblock_s*	next;
-    struct memblock_s*	prev;
 } memblock_t;
 
 
@@ -57,6 +62,12 @@ typedef struct
     memblock_t	blocklist;
     
     memblock_t*	rover;
+
+    // bytes in allocated blocks, including headers
+    int		used;
+    int		peak;
+
+    memspeed_t	speed;
     
 } memzone_t;
 
@@ -66,23 +77,330 @@ memzone_t*	mainzone;
 
 byte data_mem[64 * 1024] = {1}; // chunk of .data / DTCMRAM
 
-#ifdef TARGET_32BLIT_HW
+// The device has four zones. Host builds use arrays of the same size in
+// place of the device-only regions, so that placement behaves the same
+// and can be checked with Z_DumpStats.
 #define NUM_MEMZONES 4
+
+#ifdef TARGET_32BLIT_HW
 extern char __fb_start;
 #else
-#define NUM_MEMZONES 2
+static byte sim_fb_mem[320 * 240 * 2];
+static byte sim_d3_mem[64 * 1024 - 2 * 1024];
 #endif
 memzone_t* memzones[NUM_MEMZONES];
 
-#define SUBCHUNK_SIZE 128 // happens to be the size of mobj_t
+static const char *zone_names[NUM_MEMZONES] =
+{
+    "FB", "D3", "HEAP", "DATA"
+};
+
+static const char *speed_names[NUM_MEMSPEEDS] =
+{
+    "FAST", "NORMAL", "BULK"
+};
+
+// order that zones of each speed are tried in for each hint, prefer
+// spilling into slower memory to using up the fast zones
+static const memspeed_t speed_order[NUM_MEMSPEEDS][NUM_MEMSPEEDS] =
+{
+    {MEM_FAST, MEM_NORMAL, MEM_BULK},
+    {MEM_NORMAL, MEM_BULK, MEM_FAST},
+    {MEM_BULK, MEM_NORMAL, MEM_FAST},
+};
+
+static int zone_order[NUM_MEMSPEEDS][NUM_MEMZONES];
+
+// bytes allocated with each hint by the speed of the zone they ended up
+// in, since the last Z_ResetPeaks
+static int hint_bytes[NUM_MEMSPEEDS][NUM_MEMSPEEDS];
+
+static const char *tag_names[PU_NUM_TAGS] =
+{
+    NULL, "STATIC", "SOUND", "MUSIC", "FREE",
+    "LEVEL", "LEVSPEC", "PURGELEVEL", "CACHE"
+};
+
+// bytes in use per tag, including headers. Slab objects are counted as
+// the chunks that hold them.
+static int tag_used[PU_NUM_TAGS];
+static int tag_peak[PU_NUM_TAGS];
+
+static memzone_t *Z_ZoneForBlock(memblock_t *block)
+{
+    int i;
+
+    for (i = 0; i < NUM_MEMZONES; i++)
+    {
+        byte *base = (byte *)memzones[i];
+
+        if ((byte *)block >= base && (byte *)block < base + memzones[i]->size)
+            return memzones[i];
+    }
+
+    I_Error ("Z_ZoneForBlock: block %p is not in any zone", block);
+    return NULL;
+}
+
+// Called when no zone has room for an allocation, to free static blocks
+// that are only being kept around as a cache
+static purgehook_t purge_hook = NULL;
+
+void Z_SetPurgeHook(purgehook_t hook)
+{
+    purge_hook = hook;
+}
+
+static void Z_AddTagUsage(int tag, int size)
+{
+    tag_used[tag] += size;
+    if (tag_used[tag] > tag_peak[tag])
+        tag_peak[tag] = tag_used[tag];
+}
+
+static void Z_AddUsage(memzone_t *zone, int tag, int size)
+{
+    zone->used += size;
+    if (zone->used > zone->peak)
+        zone->peak = zone->used;
+
+    Z_AddTagUsage(tag, size);
+}
+
+//
+// SMALL OBJECT ALLOCATOR
+//
+// Small PU_LEVEL/PU_LEVSPEC allocations (mobjs and thinkers) are
+// packed into chunks of NUM_SUBCHUNKS objects of the same size class,
+// with a smaller header than a memblock_t. Each object's header points
+// back to its chunk, and each class keeps a list of chunks with free
+// slots, so allocating and freeing are O(1). Empty chunks are returned
+// to the zone. The chunks are normal zone blocks with the same tag, so
+// Z_FreeTags frees them at the end of the level.
+//
+
 #define NUM_SUBCHUNKS 32
-struct mem_chunk_t {
+#define CHUNK_FULL 0xFFFFFFFF
+
+typedef struct mem_slab_s mem_slab_t;
+
+typedef struct mem_chunk_s
+{
+    mem_slab_t *slab;
     uint32_t used;
-    uint8_t data[SUBCHUNK_SIZE * NUM_SUBCHUNKS];
-    mem_chunk_t *next;
+
+    // partially free list, only valid if used != CHUNK_FULL
+    struct mem_chunk_s *next;
+    struct mem_chunk_s *prev;
+    // followed by NUM_SUBCHUNKS * (slabheader_t + slab->size)
+} mem_chunk_t;
+
+typedef struct
+{
+    mem_chunk_t *chunk;
+    int slot;
+    int idtag;  // SLABID | tag, PU_FREE if free
+} slabheader_t;
+
+struct mem_slab_s
+{
+    int size;
+    int tag;
+
+    mem_chunk_t *partial; // chunks with at least one free slot
+
+    // stats
+    int numchunks;
+    int inuse;
+    int maxinuse;
+    unsigned int allocs;
 };
 
-mem_chunk_t *mem_chunks = NULL;
+// these cover mobj_t (128 on device) and the sector special thinkers
+static const int slab_sizes[] = {32, 48, 64, 128};
+
+#define NUM_SLAB_SIZES (sizeof(slab_sizes) / sizeof(*slab_sizes))
+#define MAX_SLAB_SIZE 128
+
+static mem_slab_t slabs[2][NUM_SLAB_SIZES]; // PU_LEVEL, PU_LEVSPEC
+
+// small objects go through the zones like any other block, for
+// doom-benchmark to compare
+boolean noslabs = false;
+
+static void Z_ResetSlabs(int lowtag, int hightag)
+{
+    int i, j;
+
+    for (i = 0; i < 2; i++)
+    {
+        for (j = 0; j < NUM_SLAB_SIZES; j++)
+        {
+            mem_slab_t *slab = &slabs[i][j];
+
+            slab->size = slab_sizes[j];
+            slab->tag = PU_LEVEL + i;
+
+            if (slab->tag < lowtag || slab->tag > hightag)
+                continue;
+
+            slab->partial = NULL;
+            slab->numchunks = 0;
+            slab->inuse = 0;
+            slab->maxinuse = 0;
+            slab->allocs = 0;
+        }
+    }
+}
+
+static mem_slab_t *Z_FindSlab(int size, int tag)
+{
+    int i;
+
+    if (size > MAX_SLAB_SIZE || (tag != PU_LEVEL && tag != PU_LEVSPEC))
+        return NULL;
+
+    for (i = 0; i < NUM_SLAB_SIZES; i++)
+    {
+        if (size <= slab_sizes[i])
+            return &slabs[tag - PU_LEVEL][i];
+    }
+
+    return NULL;
+}
+
+static void Z_UnlinkChunk(mem_chunk_t *chunk)
+{
+    if (chunk->prev)
+        chunk->prev->next = chunk->next;
+    else
+        chunk->slab->partial = chunk->next;
+
+    if (chunk->next)
+        chunk->next->prev = chunk->prev;
+}
+
+static void Z_LinkChunk(mem_chunk_t *chunk)
+{
+    mem_slab_t *slab = chunk->slab;
+
+    chunk->prev = NULL;
+    chunk->next = slab->partial;
+
+    if (slab->partial)
+        slab->partial->prev = chunk;
+
+    slab->partial = chunk;
+}
+
+static void *Z_SlabAlloc(mem_slab_t *slab)
+{
+    mem_chunk_t *chunk;
+    slabheader_t *header;
+    int stride;
+    int i;
+
+    stride = sizeof(slabheader_t) + slab->size;
+    chunk = slab->partial;
+
+    if (chunk == NULL)
+    {
+        byte *data;
+
+        chunk = (mem_chunk_t *)Z_Malloc(sizeof(mem_chunk_t) + stride * NUM_SUBCHUNKS, slab->tag, NULL);
+        chunk->slab = slab;
+        chunk->used = 0;
+        Z_LinkChunk(chunk);
+        slab->numchunks++;
+
+        data = (byte *)chunk + sizeof(mem_chunk_t);
+
+        for (i = 0; i < NUM_SUBCHUNKS; i++)
+        {
+            header = (slabheader_t *)(data + i * stride);
+            header->chunk = chunk;
+            header->slot = i;
+            header->idtag = SLABID | PU_FREE;
+        }
+    }
+
+    // first free slot
+    i = __builtin_ctz(~chunk->used);
+    chunk->used |= 1u << i;
+
+    if (chunk->used == CHUNK_FULL)
+        Z_UnlinkChunk(chunk);
+
+    header = (slabheader_t *)((byte *)chunk + sizeof(mem_chunk_t) + i * stride);
+    header->idtag = SLABID | slab->tag;
+
+    slab->allocs++;
+    slab->inuse++;
+    if (slab->inuse > slab->maxinuse)
+        slab->maxinuse = slab->inuse;
+
+    return header + 1;
+}
+
+static void Z_SlabFree(void *ptr)
+{
+    slabheader_t *header = (slabheader_t *)ptr - 1;
+    mem_chunk_t *chunk = header->chunk;
+    mem_slab_t *slab = chunk->slab;
+
+    if (header->idtag == (SLABID | PU_FREE))
+        I_Error ("Z_Free: freed a slab object twice");
+
+    header->idtag = SLABID | PU_FREE;
+
+    if (chunk->used == CHUNK_FULL)
+        Z_LinkChunk(chunk);
+
+    chunk->used &= ~(1u << header->slot);
+    slab->inuse--;
+
+    // release empty chunks, but keep one around so that something that
+    // keeps spawning and removing a single object doesn't thrash
+    if (chunk->used == 0 && (chunk->prev || chunk->next))
+    {
+        Z_UnlinkChunk(chunk);
+        slab->numchunks--;
+        Z_Free(chunk);
+    }
+}
+
+//
+// Z_DumpSlabs
+// Prints usage of the small object allocator, including how much
+// header space it saves compared to using memblock_ts.
+//
+void Z_DumpSlabs (void)
+{
+    int i, j;
+    boolean header = false;
+
+    for (i = 0; i < 2; i++)
+    {
+        for (j = 0; j < NUM_SLAB_SIZES; j++)
+        {
+            mem_slab_t *slab = &slabs[i][j];
+
+            if (!slab->allocs)
+                continue;
+
+            if (!header)
+            {
+                printf ("slab  tag  size  chunks  inuse  max  allocs  saved\n");
+                header = true;
+            }
+
+            printf ("     %3i  %4i  %6i  %5i  %3i  %6u  %5i\n",
+                    slab->tag, slab->size, slab->numchunks, slab->inuse,
+                    slab->maxinuse, slab->allocs,
+                    slab->inuse * (int)(sizeof(memblock_t) - sizeof(slabheader_t)));
+        }
+    }
+}
 
 //
 // Z_ClearZone
@@ -107,15 +425,16 @@ void Z_ClearZone (memzone_t* zone)
 
     block->size = zone->size - sizeof(memzone_t);
 
-    mem_chunks = NULL;
+    zone->used = zone->peak = 0;
 }
 
-static void InitZone(byte *base, int size, memzone_t **zoneptr)
+static void InitZone(byte *base, int size, memspeed_t speed, memzone_t **zoneptr)
 {
     memblock_t*	block;
 
     memzone_t *zone = (memzone_t *)base;
     zone->size = size;
+    zone->speed = speed;
 
     // set the entire zone to one free block
     zone->blocklist.next =
@@ -133,9 +452,9 @@ static void InitZone(byte *base, int size, memzone_t **zoneptr)
     
     block->size = zone->size - sizeof(memzone_t);
 
-    *zoneptr = zone;
+    zone->used = zone->peak = 0;
 
-    mem_chunks = NULL;
+    *zoneptr = zone;
 }
 
 //
@@ -147,7 +466,7 @@ void Z_Init (void)
     int		size;
 
     byte *base = I_ZoneBase (&size);
-    InitZone(base, size, &mainzone);
+    InitZone(base, size, MEM_NORMAL, &mainzone);
 
     int i = 0;
 
@@ -156,15 +475,34 @@ void Z_Init (void)
     // We know that 2/3 of the framebuffer is unused in paletted mode, steal that for the allocator
     char *unused_fb_start = &__fb_start + 320 * 240;
     const uint32_t unused_fb_len = 320 * 240 * 2;
-    InitZone((byte *)unused_fb_start, unused_fb_len, &memzones[i++]);
+    InitZone((byte *)unused_fb_start, unused_fb_len, MEM_BULK, &memzones[i++]);
 
     // Steal most of RAM_D3
     const int fw_usage = 2 * 1024; // atttempt to avoid anything the firmware might be using
-    InitZone((byte *)0x38000000 + fw_usage, 64 * 1024 - fw_usage, &memzones[i++]);
+    InitZone((byte *)0x38000000 + fw_usage, 64 * 1024 - fw_usage, MEM_BULK, &memzones[i++]);
+#else
+    InitZone(sim_fb_mem, sizeof(sim_fb_mem), MEM_BULK, &memzones[i++]);
+    InitZone(sim_d3_mem, sizeof(sim_d3_mem), MEM_BULK, &memzones[i++]);
 #endif
 
     memzones[i++] = mainzone; // heap
-    InitZone(data_mem, sizeof(data_mem), &memzones[i++]); // .data
+    InitZone(data_mem, sizeof(data_mem), MEM_FAST, &memzones[i++]); // .data
+
+    for (int hint = 0; hint < NUM_MEMSPEEDS; hint++)
+    {
+        int n = 0;
+
+        for (int s = 0; s < NUM_MEMSPEEDS; s++)
+        {
+            for (i = 0; i < NUM_MEMZONES; i++)
+            {
+                if (memzones[i]->speed == speed_order[hint][s])
+                    zone_order[hint][n++] = i;
+            }
+        }
+    }
+
+    Z_ResetSlabs(PU_LEVEL, PU_LEVSPEC);
 }
 
 
@@ -180,35 +518,12 @@ void Z_Free (void* ptr)
 
     if ((block->idtag & 0xFFFFFF00) != ZONEID)
     {
-        // check chunks
-        mem_chunk_t *found_block = NULL, *prev_block = NULL;
-
-        for(mem_chunk_t *block = mem_chunks; block != NULL; block = block->next)
-        {
-            if(ptr > block && ptr < block + sizeof(mem_chunk_t))
-            {
-                found_block = block;
-                break;
-            }
-            prev_block = block;
-        }
-
-        if(found_block)
+        if ((block->idtag & 0xFFFFFF00) == SLABID)
         {
-            int i = ((intptr_t)ptr - (intptr_t)found_block->data) / SUBCHUNK_SIZE;
-            found_block->used &= ~(1 << i);
-
-            if(found_block->used == 0)
-            {
-                if(prev_block)
-                    prev_block->next = found_block->next;
-                else
-                    mem_chunks = found_block->next;
-
-                Z_Free(found_block);
-            }
+            Z_SlabFree(ptr);
             return;
         }
+
 	    I_Error ("Z_Free: freed a pointer without ZONEID");
     }
 		
@@ -218,6 +533,8 @@ void Z_Free (void* ptr)
 	    *block->user = 0;
     }
 
+    Z_AddUsage(Z_ZoneForBlock(block), block->idtag & 0xFF, -block->size);
+
     // mark as free
     block->idtag = PU_FREE;
     block->user = NULL;
@@ -255,125 +572,134 @@ void Z_Free (void* ptr)
 
 
 //
-// Z_Malloc
+// Z_ScanZone
+// Looks for the first free block of sufficient size in the zone,
+// throwing out any purgable blocks along the way. Returns NULL if there
+// isn't one. size includes the block header.
+//
+static memblock_t *Z_ScanZone(memzone_t *zone, int size)
+{
+    memblock_t*	start;
+    memblock_t* rover;
+    memblock_t*	base;
+
+    // if there is a free block behind the rover,
+    //  back up over them
+    base = zone->rover;
+    
+    if (base->prev->idtag == PU_FREE)
+        base = base->prev;
+    
+    rover = base;
+    start = base->prev;
+    
+    do
+    {
+        bool donelist = rover == start;
+        //if (rover == start)
+        //    break;
+    
+        if (rover->idtag != PU_FREE)
+        {
+            if ((rover->idtag & 0xFF) < PU_PURGELEVEL)
+            {
+                // hit a block that can't be purged,
+                // so move base past it
+                base = rover = rover->next;
+            }
+            else
+            {
+                // free the rover block (adding the size to base)
+
+                // the rover can be the base block
+                base = base->prev;
+                Z_Free ((byte *)rover+sizeof(memblock_t));
+                base = base->next;
+                rover = base->next;
+            }
+        }
+        else
+        {
+            rover = rover->next;
+        }
+
+        // scanned all the way around the list
+        if(donelist)
+            break;
+
+    } while (base->idtag != PU_FREE || base->size < size);
+
+    if(base->idtag == PU_FREE && base->size >= size)
+        return base;
+
+    return NULL;
+}
+
+
+//
+// Z_AllocBlock
 // You can pass a NULL user if the tag is < PU_PURGELEVEL.
+// Zones of the hinted speed are tried first.
 //
 #define MINFRAGMENT		64
 
 
-void*
-Z_Malloc
+static void*
+Z_AllocBlock
 ( int		size,
   int		tag,
-  void*		user )
+  void*		user,
+  memspeed_t	hint,
+  boolean	fatal )
 {
     int		extra;
-    memblock_t*	start;
-    memblock_t* rover;
     memblock_t* newblock;
     memblock_t*	base;
     void *result;
-    int i;
+    memzone_t *zone;
+    int n;
 
     size = (size + MEM_ALIGN - 1) & ~(MEM_ALIGN - 1);
 
-    // small object allocator (basically for mobjs)
-    if(size == SUBCHUNK_SIZE && tag == PU_LEVEL)
+    // small object allocator (mobjs and thinkers)
+    if (user == NULL && !noslabs)
     {
-        mem_chunk_t *found_block = NULL;
-
-        for(mem_chunk_t *block = mem_chunks; block != NULL; block = block->next)
-        {
-            if(block->used != (1ull << NUM_SUBCHUNKS) - 1)
-            {
-                found_block = block;
-                break;
-            }
-        }
+        mem_slab_t *slab = Z_FindSlab(size, tag);
 
-        if(!found_block)
-        {
-            found_block = (mem_chunk_t *)Z_Malloc(sizeof(mem_chunk_t), tag, NULL);
-            found_block->used = 0;
-            found_block->next = mem_chunks;
-            mem_chunks = found_block;
-        }
-
-        for(int i = 0; i < NUM_SUBCHUNKS; i++)
-        {
-            if(!(found_block->used & (1 << i)))
-            {
-                found_block->used |= (1 << i);
-                return found_block->data + (i * SUBCHUNK_SIZE);
-            }
-        }
+        if (slab)
+            return Z_SlabAlloc(slab);
     }
 
-    // scan through the block list,
-    // looking for the first free block
-    // of sufficient size,
-    // throwing out any purgable blocks along the way.
-
     // account for size of block header
     size += sizeof(memblock_t);
     
 
-    for(i = 0; i < NUM_MEMZONES; i++)
+    while (1)
     {
-        // if there is a free block behind the rover,
-        //  back up over them
-        base = memzones[i]->rover;
-        
-        if (base->prev->idtag == PU_FREE)
-            base = base->prev;
-        
-        rover = base;
-        start = base->prev;
-        
-        do
+        for(n = 0; n < NUM_MEMZONES; n++)
         {
-            bool donelist = rover == start;
-            //if (rover == start)
-            //    break;
-        
-            if (rover->idtag != PU_FREE)
-            {
-                if ((rover->idtag & 0xFF) < PU_PURGELEVEL)
-                {
-                    // hit a block that can't be purged,
-                    // so move base past it
-                    base = rover = rover->next;
-                }
-                else
-                {
-                    // free the rover block (adding the size to base)
-
-                    // the rover can be the base block
-                    base = base->prev;
-                    Z_Free ((byte *)rover+sizeof(memblock_t));
-                    base = base->next;
-                    rover = base->next;
-                }
-            }
-            else
-            {
-                rover = rover->next;
-            }
+            zone = memzones[zone_order[hint][n]];
 
-            // scanned all the way around the list
-            if(donelist)
-                break;
+            base = Z_ScanZone(zone, size);
 
-        } while (base->idtag != PU_FREE || base->size < size);
+            if (base)
+                break;
+        }
 
-        if(base->idtag == PU_FREE && base->size >= size)
+        // only once it would otherwise fail, have the purge hook free
+        // something and try again
+        if (base || purge_hook == NULL || !purge_hook())
             break;
-
-        base = NULL;
     }
 
     if(!base)
+    {
+        if (!fatal)
+            return NULL;
+
+        Z_DumpStats();
         I_Error ("Z_Malloc: failed on allocation of %i bytes", size);
+    }
     
     // found a block big enough
     extra = base->size - size;
@@ -400,6 +726,9 @@ Z_Malloc
     base->user = user;
     base->idtag = tag | ZONEID;
 
+    Z_AddUsage(zone, tag, base->size);
+    hint_bytes[hint][zone->speed] += base->size;
+
     result  = (void *) ((byte *)base + sizeof(memblock_t));
 
     if (base->user)
@@ -408,11 +737,31 @@ Z_Malloc
     }
 
     // next allocation will start looking here
-    memzones[i]->rover = base->next;	
+    zone->rover = base->next;	
     
     return result;
 }
 
+void *Z_Malloc(int size, int tag, void *user)
+{
+    return Z_AllocBlock(size, tag, user, MEM_NORMAL, true);
+}
+
+void *Z_MallocHint(int size, int tag, void *user, memspeed_t hint)
+{
+    return Z_AllocBlock(size, tag, user, hint, true);
+}
+
+//
+// Z_TryMalloc
+// Like Z_MallocHint, but returns NULL if there isn't enough memory.
+// Purgable blocks may still have been freed.
+//
+void *Z_TryMalloc(int size, int tag, void *user, memspeed_t hint)
+{
+    return Z_AllocBlock(size, tag, user, hint, false);
+}
+
 
 
 //
@@ -443,8 +792,8 @@ Z_FreeTags
         }
     }
 
-    if(lowtag <= PU_LEVEL)
-        mem_chunks = NULL;
+    // the chunks were freed above
+    Z_ResetSlabs(lowtag, hightag);
 }
 
 // TODO: everything below only looks at mainzone
@@ -569,6 +918,9 @@ void Z_ChangeTag2(void *ptr, int tag, char *file, int line)
         I_Error("%s:%i: Z_ChangeTag: an owner is required "
                 "for purgable blocks", file, line);
 
+    Z_AddTagUsage(block->idtag & 0xFF, -block->size);
+    Z_AddTagUsage(tag, block->size);
+
     block->idtag = tag | ZONEID;
 }
 
@@ -615,3 +967,137 @@ unsigned int Z_ZoneSize(void)
     return mainzone->size;
 }
 
+//
+// ZONE TELEMETRY
+//
+
+int Z_NumZones(void)
+{
+    return NUM_MEMZONES;
+}
+
+const char *Z_ZoneName(int zone)
+{
+    return zone_names[zone];
+}
+
+//
+// Z_GetZoneStats
+// Usage counters are kept up to date by Z_Malloc/Z_Free, the free space
+// figures need a walk of the block list.
+//
+void Z_GetZoneStats(int zone, zonestats_t *stats)
+{
+    memzone_t *z = memzones[zone];
+    memblock_t *block;
+    int run = 0;
+
+    memset(stats, 0, sizeof(*stats));
+
+    stats->size = z->size;
+    stats->used = z->used;
+    stats->peak = z->peak;
+
+    for (block = z->blocklist.next;
+         block != &z->blocklist;
+         block = block->next)
+    {
+        if (block->idtag == PU_FREE)
+        {
+            stats->free += block->size;
+            stats->free_blocks++;
+        }
+        else if ((block->idtag & 0xFF) >= PU_PURGELEVEL)
+        {
+            stats->purgable += block->size;
+        }
+        else
+        {
+            run = 0;
+            continue;
+        }
+
+        // Z_Malloc can purge its way through a run of free and
+        // purgable blocks, so that's the largest it can hand out
+        run += block->size;
+        if (run > stats->largest_free)
+            stats->largest_free = run;
+    }
+
+    if (stats->free + stats->purgable > 0)
+    {
+        stats->fragmentation = 100 - (int)((long long)stats->largest_free * 100
+                                           / (stats->free + stats->purgable));
+    }
+}
+
+void Z_GetTagStats(int tag, int *used, int *peak)
+{
+    *used = tag_used[tag];
+    *peak = tag_peak[tag];
+}
+
+//
+// Z_ResetPeaks
+// Restarts the high-water marks from the current usage and clears the
+// placement counts.
+//
+void Z_ResetPeaks(void)
+{
+    int i;
+
+    for (i = 0; i < NUM_MEMZONES; i++)
+        memzones[i]->peak = memzones[i]->used;
+
+    for (i = 0; i < PU_NUM_TAGS; i++)
+        tag_peak[i] = tag_used[i];
+
+    memset(hint_bytes, 0, sizeof(hint_bytes));
+}
+
+//
+// Z_DumpStats
+// Prints usage per zone and per tag. All sizes include block headers.
+//
+void Z_DumpStats(void)
+{
+    zonestats_t stats;
+    int i;
+
+    int j;
+
+    printf ("zone  speed      size    used    peak   purge    free  largest  blocks  frag\n");
+
+    for (i = 0; i < NUM_MEMZONES; i++)
+    {
+        Z_GetZoneStats(i, &stats);
+
+        printf ("%-4s  %-6s  %7i %7i %7i %7i %7i  %7i  %6i  %3i%%\n",
+                zone_names[i], speed_names[memzones[i]->speed],
+                stats.size, stats.used, stats.peak,
+                stats.purgable, stats.free, stats.largest_free,
+                stats.free_blocks, stats.fragmentation);
+    }
+
+    printf ("tag            used    peak\n");
+
+    for (i = PU_STATIC; i < PU_NUM_TAGS; i++)
+    {
+        if (i == PU_FREE)
+            continue;
+
+        printf ("%-10s  %7i %7i\n", tag_names[i], tag_used[i], tag_peak[i]);
+    }
+
+    printf ("placed as    in FAST  NORMAL    BULK\n");
+
+    for (i = 0; i < NUM_MEMSPEEDS; i++)
+    {
+        printf ("%-10s  ", speed_names[i]);
+
+        for (j = 0; j < NUM_MEMSPEEDS; j++)
+            printf (" %7i", hint_bytes[i][j]);
+
+        printf ("\n");
+    }
+}
@@ -26,6 +26,8 @@
 
 #include <stdio.h>
 
+#include "doomtype.h"
+
 //
 // ZONE MEMORY
 // PU - purge tags.
@@ -49,12 +51,45 @@ enum
     PU_NUM_TAGS
 };
         
+// Placement hints, each memzone has one of these speeds and Z_MallocHint
+// tries the zones with the requested speed first.
+typedef enum
+{
+    MEM_FAST,           // per-frame renderer data
+    MEM_NORMAL,
+    MEM_BULK,           // large level data that is rarely touched
+
+    NUM_MEMSPEEDS
+} memspeed_t;
+
+typedef struct
+{
+    int size;           // including the zone header
+    int used;           // bytes in allocated blocks, including headers
+    int peak;           // high-water mark of used
+    int purgable;       // bytes in blocks >= PU_PURGELEVEL (part of used)
+    int free;
+    int largest_free;   // largest run of free/purgable blocks
+    int free_blocks;
+    int fragmentation;  // percentage of free/purgable memory outside that run
+} zonestats_t;
+
+// Frees a block that it is holding so that an allocation that doesn't fit
+// in any zone can be tried again. Returns false if it has nothing left to
+// free.
+typedef boolean (*purgehook_t)(void);
+
+
+extern boolean noslabs;
 
 void	Z_Init (void);
 void*	Z_Malloc (int size, int tag, void *ptr);
+void*	Z_MallocHint (int size, int tag, void *ptr, memspeed_t hint);
+void*	Z_TryMalloc (int size, int tag, void *ptr, memspeed_t hint);
 void    Z_Free (void *ptr);
 void    Z_FreeTags (int lowtag, int hightag);
 void    Z_DumpHeap (int lowtag, int hightag);
+void    Z_DumpSlabs (void);
 void    Z_FileDumpHeap (FILE *f);
 void    Z_CheckHeap (void);
 void    Z_ChangeTag2 (void *ptr, int tag, char *file, int line);
@@ -62,6 +97,15 @@ void    Z_ChangeUser(void *ptr, void **user);
 int     Z_FreeMemory (void);
 unsigned int Z_ZoneSize(void);
 
+int     Z_NumZones(void);
+const char *Z_ZoneName(int zone);
+void    Z_GetZoneStats(int zone, zonestats_t *stats);
+void    Z_GetTagStats(int tag, int *used, int *peak);
+void    Z_ResetPeaks(void);
+void    Z_DumpStats(void);
+
+void    Z_SetPurgeHook(purgehook_t hook);
+
 //
 // This is used to get the local FILE:LINE info from CPP
 // prior to really call the function in question.